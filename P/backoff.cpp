@@ -0,0 +1,83 @@
+#include "backoff.h"
+
+#include <string.h> // strcmp
+#include <sched.h>  // sched_yield
+
+backoff_t backoffScheme = BACKOFF_NONE_e;
+unsigned backoffCap = BACKOFF_CAP;
+
+// xorshift32, one per thread so jitter needs no shared state
+static thread_local unsigned backoffSeed = 0;
+
+/******************************************************************************
+ * @brief Backoff_Select - Picks the scheme from its command line name
+ * @param name - "none", "exp" or "yield"
+ * @return false if the name is unknown
+ *****************************************************************************/
+bool Backoff_Select(const char * name)
+{
+    if (strcmp(name, "none") == 0)
+    {
+        backoffScheme = BACKOFF_NONE_e;
+    }
+    else if (strcmp(name, "exp") == 0)
+    {
+        backoffScheme = BACKOFF_EXP_e;
+    }
+    else if (strcmp(name, "yield") == 0)
+    {
+        backoffScheme = BACKOFF_YIELD_e;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+const char * Backoff_Name(void)
+{
+    switch (backoffScheme)
+    {
+        case (BACKOFF_EXP_e):   return "exp";
+        case (BACKOFF_YIELD_e): return "yield";
+        default:                return "none";
+    }
+}
+
+/******************************************************************************
+ * @brief backoff::Wait - Pauses for a random count below limit and doubles
+ *                        it, or yields once limit is past the cap. limit
+ *                        stops growing just past the cap, so it can never
+ *                        wrap to 0.
+ * @param none
+ * @return none
+ *****************************************************************************/
+void backoff::Wait()
+{
+    if (scheme == BACKOFF_YIELD_e || limit > backoffCap)
+    {
+        sched_yield();
+        return;
+    }
+    if (backoffSeed == 0)
+    {
+        backoffSeed = (unsigned)(size_t)&backoffSeed | 1;   // Differs per thread
+    }
+    backoffSeed ^= backoffSeed << 13;
+    backoffSeed ^= backoffSeed >> 17;
+    backoffSeed ^= backoffSeed << 5;
+    unsigned spins = backoffSeed % limit + 1;
+    for (volatile unsigned i = 0; i < spins; ++i)
+    {
+        __builtin_ia32_pause();
+    }
+    if (limit <= backoffCap / 2)
+    {
+        limit <<= 1;
+    }
+    else
+    {
+        limit = backoffCap + 1;
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef BACKOFF_H
+#define BACKOFF_H
+
+#include <stdio.h>
+
+#define BACKOFF_MIN 4       // Pause loops after the first failed attempt
+#define BACKOFF_CAP 1024    // Default cap, --backoff-cap changes it
+#define BACKOFF_CAP_MAX (1u << 20)  // Largest --backoff-cap, tens of milliseconds of pausing
+
+/******************************************************************************
+ * Contention Backoff
+ * A container makes a backoff on the stack at the start of an operation and
+ * calls pause() each time a CAS loses. The wait is a random number of pause
+ * instructions below a limit that doubles per failure, the randomness
+ * keeping the losers from all coming back at once. Once the limit passes the
+ * cap the thread yields its core instead, as whoever it lost to may be
+ * waiting for it. The scheme is picked once at start up
+ * (--backoff=none|exp|yield), none keeps the old tight retry loops.
+ * Containers whose algorithm has to wait (the basket queue, the elimination
+ * window, flat-combining waiters) pass exp as their fallback, so they still
+ * wait under none and follow --backoff and --backoff-cap otherwise.
+ *****************************************************************************/
+typedef enum
+{
+    BACKOFF_NONE_e,     // Retry straight away
+    BACKOFF_EXP_e,      // Randomised exponential pause, then yield
+    BACKOFF_YIELD_e     // sched_yield on every failure
+}backoff_t;
+
+extern backoff_t backoffScheme;
+extern unsigned backoffCap;
+
+bool Backoff_Select(const char * name);
+const char * Backoff_Name(void);
+
+class backoff
+{
+public:
+    /**************************************************************************
+     * @param fallback - scheme used while --backoff is none, for containers
+     *                   whose algorithm needs a backoff of its own
+     *        start    - limit of the first pause, in pause loops
+     *************************************************************************/
+    backoff(backoff_t fallback = BACKOFF_NONE_e, unsigned start = BACKOFF_MIN)
+        : scheme((backoffScheme == BACKOFF_NONE_e) ? fallback : backoffScheme),
+          limit(start){}
+    void pause()
+    {
+        if (scheme != BACKOFF_NONE_e)
+        {
+            Wait();
+        }
+    }
+private:
+    backoff_t scheme;
+    unsigned limit;
+    void Wait();
+};
+
+#endif
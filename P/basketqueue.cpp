@@ -2,196 +2,251 @@
 
 /******************************************************************************
  * Basket Queue
+ * Credit goes to Moshe Hoffman, Ori Shalev and Nir Shavit - "The Baskets
+ * Queue". Under hazard pointers slot 0 covers the head (or tail) node and
+ * slots 1 and 2 leapfrog along any chain walked past it.
  *****************************************************************************/
 
 /******************************************************************************
  * @brief init_queue - Initializes a temp node nd
  * @param q   - the custom queue passed in
  * @return none
- *****************************************************************************/ 
+ *****************************************************************************/
 void init_queue(queue_t * q)
 {
     node_t * nd = new node_t;
-    nd->next.ptr = NULL;
-    nd->next.deleted = 0;
-    nd->next.tag = 0;
-
-    q->tail.ptr = nd;
-    q->tail.deleted = 0;
-    q->tail.tag = 0;
-
-    q->head.ptr = nd;
-    q->head.deleted = 0;
-    q->head.tag = 0;
+    nd->value = 0;
+    nd->next.store(Basket_Pointer(NULL, 0, 0));
+    q->tail.store(Basket_Pointer(nd, 0, 0));
+    q->head.store(Basket_Pointer(nd, 0, 0));
+}
 
+/******************************************************************************
+ * @brief destroy_queue - Frees the dummy and everything not yet freed by
+ *                        free_chain. No thread may be using the queue.
+ * @param q   - the custom queue passed in
+ * @return none
+ *****************************************************************************/
+void destroy_queue(queue_t * q)
+{
+    node_t * nd = q->head.load().ptr();
+    while (nd != NULL)
+    {
+        node_t * next = nd->next.load().ptr();
+        delete nd;
+        nd = next;
+    }
 }
-void backoff_scheme()
+
+/******************************************************************************
+ * @brief Basket_Catchup - Walks from next to the real last node while tail is
+ *                         still the queue's tail. Nodes past the tail are
+ *                         never freed, so validating tail covers each hop.
+ * @param q    - the custom queue passed in
+ *        tail - the tail snapshot
+ *        next - the node after tail
+ * @return the last node found
+ *****************************************************************************/
+static pointer_t Basket_Catchup(queue_t * q, pointer_t tail, pointer_t next)
 {
-	printf("backoff\n");
+    int slot = 1;
+    while (true)
+    {
+        Reclaim_Publish(slot, next.ptr());
+        if (q->tail.load() != tail)
+        {
+            return next;
+        }
+        pointer_t after = next.ptr()->next.load();
+        if (after.ptr() == NULL)
+        {
+            return next;
+        }
+        next = after;
+        slot = 3 - slot;
+    }
 }
+
 /******************************************************************************
  * @brief Basket_Enqueue - Enqueue function from Moshe, Ori, and Nir's paper
  * @param q   - the custom queue passed in
  *        val - value that is placed into the queue
  * @return will return true or continue to spin
- *****************************************************************************/ 
+ *****************************************************************************/
 bool Basket_Enqueue(queue_t * q, int val)
 {
     node_t * nd = new node_t;
     nd->value = val;
+    backoff b(BACKOFF_EXP_e);   // The algorithm relies on one, --backoff only changes it
+    Reclaim_Enter();
     while(true)
     {
-        pointer_t tail = q->tail;
-        pointer_t next = tail.ptr->next;
-
-        pointer_t temp;
-        temp.ptr = nd;
-        temp.deleted = 0;
-        temp.tag = tail.tag+1;
-        if (tail.ptr == q->tail.ptr)
+        pointer_t tail = q->tail.load();
+        Reclaim_Publish(0, tail.ptr());
+        if (tail != q->tail.load())
         {
-	        if (next.ptr == NULL)
-	        {
-	            nd->next.ptr = NULL;
-	            nd->next.deleted = 0;
-	            nd->next.tag = tail.tag+2;
-				if (__sync_bool_compare_and_swap(&tail.ptr->next.ptr, next.ptr, temp.ptr) &&
-				   (__sync_bool_compare_and_swap(&tail.ptr->next.deleted, next.deleted, temp.deleted)) &&
-				   (__sync_bool_compare_and_swap(&tail.ptr->next.tag, next.tag, temp.tag)))
-	            {
-	                __sync_bool_compare_and_swap(&q->tail.ptr, tail.ptr, temp.ptr);
-	                __sync_bool_compare_and_swap(&q->tail.deleted, tail.deleted, temp.deleted);
-	                __sync_bool_compare_and_swap(&q->tail.tag, tail.tag, temp.tag);
-	                printf("Basket-EN:%d\n", val);
-	                return true;
-	            }
-	            next = tail.ptr->next;
-	            while((next.tag == tail.tag+1) && (!next.deleted))
-	            {
-	                backoff_scheme();
-	                nd->next = next;
-	                if (__sync_bool_compare_and_swap(&tail.ptr->next.ptr, next.ptr, temp.ptr) &&
-	                   (__sync_bool_compare_and_swap(&tail.ptr->next.deleted, next.deleted, temp.deleted)) &&
-	                   (__sync_bool_compare_and_swap(&tail.ptr->next.tag, next.tag, temp.tag)))
-	                {
-	                	// printf("Basket-EN:%d\n", val);
-	                    return true;
-	                }
-	                next = tail.ptr->next;
-	            }
-	        }
-	        else
-	        {
-	            while ((next.ptr->next.ptr != NULL) && (q->tail.ptr==tail.ptr))
-	            {
-	                next = next.ptr->next;
-	            }
-	        	temp.ptr = next.ptr;
-	            __sync_bool_compare_and_swap(&q->tail.ptr, tail.ptr, temp.ptr);
-	            __sync_bool_compare_and_swap(&q->tail.deleted, tail.deleted, temp.deleted);
-	            __sync_bool_compare_and_swap(&q->tail.tag, tail.tag, temp.tag);
-	        }
-	    }
+            continue;
+        }
+        pointer_t next = tail.ptr()->next.load();
+        if (tail == q->tail.load())
+        {
+            pointer_t mine = Basket_Pointer(nd, 0, tail.tag() + 1);
+            if (next.ptr() == NULL)
+            {
+                nd->next.store(Basket_Pointer(NULL, 0, tail.tag() + 2));
+                if (tail.ptr()->next.compare_exchange_strong(next, mine))
+                {
+                    pointer_t expected = tail;
+                    q->tail.compare_exchange_strong(expected, mine);
+                    Reclaim_Exit();
+                    q->ready.notify();
+                    return true;
+                }
+                // Lost the race: join the basket of the winners while it
+                // is still the last one and nobody dequeued from it
+                next = tail.ptr()->next.load();
+                while ((next.tag() == (uint16_t)(tail.tag() + 1)) && (!next.deleted()))
+                {
+                    b.pause();
+                    nd->next.store(next);
+                    if (tail.ptr()->next.compare_exchange_strong(next, mine))
+                    {
+                        Reclaim_Exit();
+                        q->ready.notify();
+                        return true;
+                    }
+                    next = tail.ptr()->next.load();
+                }
+            }
+            else
+            {
+                next = Basket_Catchup(q, tail, next);
+                pointer_t expected = tail;
+                q->tail.compare_exchange_strong(expected, Basket_Pointer(next.ptr(), 0, tail.tag() + 1));
+            }
+        }
     }
     return false;
 }
+
 /******************************************************************************
- * @brief free_chain - Frees the leftover
+ * @brief free_chain - Moves head past a chain of dequeued nodes and retires
+ *                     them
  * @param q        - the custom queue passed in
  *        head     - starting point
  *        new_head - replace the old with this
  * @return none
- *****************************************************************************/ 
+ *****************************************************************************/
 void free_chain(queue_t * q, pointer_t head, pointer_t new_head)
 {
-	printf("here\n");
-	pointer_t temp;
-    temp.ptr = new_head.ptr;
-    temp.deleted = 0;
-    temp.tag = head.tag+1;
-	if (__sync_bool_compare_and_swap(&q->head.ptr, head.ptr, temp.ptr) &&
-		(__sync_bool_compare_and_swap(&q->head.deleted, head.deleted, temp.deleted)) &&
-		(__sync_bool_compare_and_swap(&q->head.tag, head.tag, temp.tag)))
-	{
-		while (head.ptr != new_head.ptr)
-		{
-			// reclaim node head.ptr
-			head = head.ptr->next;
-		}
-	}
+    pointer_t expected = head;
+    if (q->head.compare_exchange_strong(expected, Basket_Pointer(new_head.ptr(), 0, head.tag() + 1)))
+    {
+        while (head.ptr() != new_head.ptr())
+        {
+            node_t * unlinked = head.ptr();
+            head = unlinked->next.load();
+            Reclaim_Retire(unlinked);
+        }
+    }
 }
 
 /******************************************************************************
  * @brief Basket_Dequeue - Dequeue function from Moshe, Ori, and Nir's paper
  * @param q - the custom queue passed in
  * @return the value or empty == -2
- *****************************************************************************/ 
+ *****************************************************************************/
 int Basket_Dequeue(queue_t * q)
 {
+    backoff b(BACKOFF_EXP_e);
+    Reclaim_Enter();
     while(true)
     {
-        pointer_t head = q->head;
-        pointer_t tail = q->tail;
-        pointer_t next = head.ptr->next;
-
-        pointer_t temp;
-        temp.ptr = next.ptr;
-        temp.deleted = 0;
-        temp.tag = tail.tag+1;
-        if (head.ptr == q->head.ptr)
+        pointer_t head = q->head.load();
+        Reclaim_Publish(0, head.ptr());
+        if (head != q->head.load())
         {
-	        if (head.ptr == tail.ptr)
-	        {
-	        	printf("never here\n");
-	        	if (next.ptr == NULL)
-	        	{
-	        		return -2;
-	        	}
-	        	while ((next.ptr->next.ptr != NULL) && (q->tail.ptr == tail.ptr))
-	        	{
-	        		next = next.ptr->next;
-	        	}
-	        	__sync_bool_compare_and_swap(&q->tail.ptr, tail.ptr, temp.ptr);
-	        	__sync_bool_compare_and_swap(&q->tail.deleted, tail.deleted, temp.deleted);
-	        	__sync_bool_compare_and_swap(&q->tail.tag, tail.tag, temp.tag);
-	        }
-			else
-			{
-				pointer_t iter = head;
-				int hops = 0;
-				while ((next.deleted && (iter.ptr != tail.ptr)) && (q->head.ptr == head.ptr))
-				{
-	        		iter = next;
-	        		next = iter.ptr->next;
-	        		hops++;
-	        	}
-	        	if (q->head.ptr != head.ptr)
-	        	{
-	        		continue;
-	        	}
-	        	else if(iter.ptr == tail.ptr)
-	        	{
-	        		free_chain(q, head, iter);
-	        	}
-	        	else
-	        	{
-	        		int value = next.ptr->value;
-	    			temp.deleted = 1;
-	    			temp.tag = next.tag+1;
-	        		if (__sync_bool_compare_and_swap(&iter.ptr->next.ptr, next.ptr, temp.ptr) &&
-	        	       (__sync_bool_compare_and_swap(&iter.ptr->next.deleted, next.deleted, temp.deleted)) &&
-	        		   (__sync_bool_compare_and_swap(&iter.ptr->next.tag, next.tag, temp.tag)))
-	        		{
-	        			printf("val\n");
-	        			if (hops >= MAX_HOPS)
-	        			{
-	        				free_chain(q, head, next);
-	        			}
-	        			return value;
-	        		}
-	        		backoff_scheme();
-	        	}
-	        }
-	    }
+            continue;
+        }
+        pointer_t tail = q->tail.load();
+        pointer_t next = head.ptr()->next.load();
+        if (head == q->head.load())
+        {
+            if (head.ptr() == tail.ptr())
+            {
+                if (next.ptr() == NULL)
+                {
+                    Reclaim_Exit();
+                    return -2;
+                }
+                next = Basket_Catchup(q, tail, next);
+                pointer_t expected = tail;
+                q->tail.compare_exchange_strong(expected, Basket_Pointer(next.ptr(), 0, tail.tag() + 1));
+            }
+            else
+            {
+                // Skip the nodes already dequeued. Each one is published
+                // before it is read, and checking head again afterwards
+                // proves it had not been freed by then.
+                pointer_t iter = head;
+                int hops = 0;
+                int slot = 1;
+                bool moved = false;
+                while (true)
+                {
+                    Reclaim_Publish(slot, next.ptr());
+                    if (q->head.load() != head)
+                    {
+                        moved = true;
+                        break;
+                    }
+                    if (!next.deleted() || iter.ptr() == tail.ptr())
+                    {
+                        break;
+                    }
+                    iter = next;
+                    slot = 3 - slot;
+                    next = iter.ptr()->next.load();
+                    hops++;
+                }
+                if (moved)
+                {
+                    continue;
+                }
+                else if (iter.ptr() == tail.ptr())
+                {
+                    free_chain(q, head, iter);
+                }
+                else
+                {
+                    int value = next.ptr()->value;
+                    pointer_t expected = next;
+                    if (iter.ptr()->next.compare_exchange_strong(expected,
+                            Basket_Pointer(next.ptr(), 1, next.tag() + 1)))
+                    {
+                        if (hops >= MAX_HOPS)
+                        {
+                            free_chain(q, head, next);
+                        }
+                        Reclaim_Exit();
+                        return value;
+                    }
+                    b.pause();
+                }
+            }
+        }
     }
 }
+
+/******************************************************************************
+ * @brief Basket_Dequeue_Wait - Like Basket_Dequeue, but an empty queue is
+ *                              waited on: a short spin, then a futex park
+ *                              until an enqueue wakes it
+ * @param q       - the custom queue passed in
+ *        timeout - how long to wait, NULL to wait for ever
+ * @return the value or -2 if nothing arrived in time
+ *****************************************************************************/
+int Basket_Dequeue_Wait(queue_t * q, const struct timespec * timeout)
+{
+    return EC_Wait_For(q->ready, [q]() { return Basket_Dequeue(q); }, timeout);
+}
@@ -3,29 +3,62 @@
 
 #include <iostream>
 #include <atomic>
+#include <stdint.h>
+#include "reclaim.h"
+#include "pool.h"
+#include "backoff.h"
+#include "eventcount.h"
+
+using namespace std;
 
 extern pthread_mutex_t singleGlobalLock;
 
 #define MAX_HOPS 3  // In dequeue
 
+#define BASKET_PTR_MASK    0x0000FFFFFFFFFFFEULL  // User space pointer, nodes are 8 aligned
+#define BASKET_DELETED     0x0000000000000001ULL  // Free low bit of the pointer
+#define BASKET_TAG_SHIFT   48                     // Tag lives in the unused top bits
+
+/******************************************************************************
+ * The paper's <ptr, deleted, tag> triple packed into one 64-bit word so the
+ * whole triple is read and compare-and-swapped atomically in one instruction.
+ *****************************************************************************/
 struct node_t;      // Forward defined
 struct pointer_t {
-    node_t * ptr;
-    bool deleted;
-    uint16_t tag;
+    uint64_t word;
+    node_t * ptr() const { return (node_t *)(word & BASKET_PTR_MASK); }
+    bool deleted() const { return (word & BASKET_DELETED) != 0; }
+    uint16_t tag() const { return (uint16_t)(word >> BASKET_TAG_SHIFT); }
+    bool operator==(const pointer_t & other) const { return word == other.word; }
+    bool operator!=(const pointer_t & other) const { return word != other.word; }
 };
+
+inline pointer_t Basket_Pointer(node_t * ptr, bool deleted, uint16_t tag)
+{
+    pointer_t p;
+    p.word = ((uint64_t)(uintptr_t)ptr & BASKET_PTR_MASK) |
+             (deleted ? BASKET_DELETED : 0) |
+             ((uint64_t)tag << BASKET_TAG_SHIFT);
+    return p;
+}
+
 struct queue_t {
-    pointer_t tail;
-    pointer_t head;
+    atomic<pointer_t> tail;
+    char pad[64 - sizeof(atomic<pointer_t>)];   // Keep enqueuers off the dequeuers' line
+    atomic<pointer_t> head;
+    char pad1[64 - sizeof(atomic<pointer_t>)];  // Enqueuers read the waiter count
+    eventcount ready;       // Wakes Basket_Dequeue_Wait callers
 };
-struct node_t {
+struct node_t : public pooled {
     int value;
-    pointer_t next;
+    atomic<pointer_t> next;
 };
 
 void init_queue(queue_t * q);
+void destroy_queue(queue_t * q);
 bool Basket_Enqueue(queue_t * q, int val);
 void free_chain(queue_t * q, pointer_t head, pointer_t new_head);
 int Basket_Dequeue(queue_t * q);
+int Basket_Dequeue_Wait(queue_t * q, const struct timespec * timeout);
 
-#endif
\ No newline at end of file
+#endif
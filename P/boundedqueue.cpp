@@ -0,0 +1,152 @@
+#include "boundedqueue.h"
+
+#include <stdio.h>
+
+/******************************************************************************
+ * Bounded Blocking Queue
+ *****************************************************************************/
+boundedqueue::boundedqueue(size_t capacity) : ring(capacity)
+{
+}
+
+size_t boundedqueue::capacity()
+{
+    return ring.capacity();
+}
+
+/******************************************************************************
+ * @brief boundedqueue::Drained - Called after every dequeue. Wakes all the
+ *                                parked producers once the ring is down to
+ *                                half. Consumers keep dequeuing until the
+ *                                ring is empty, so one of them always gets
+ *                                here with the ring below half.
+ * @param none
+ * @return none
+ *****************************************************************************/
+void boundedqueue::Drained()
+{
+    if (ring.size() <= ring.capacity() / 2)
+    {
+        notFull.notify(INT_MAX);
+    }
+}
+
+/******************************************************************************
+ * @brief boundedqueue::try_enqueue - Enqueues unless the ring is full
+ * @param val - the value being enqueued
+ * @return bool - false if the ring is full
+ *****************************************************************************/
+bool boundedqueue::try_enqueue(int val)
+{
+    if (!ring.try_enqueue(val))
+    {
+        return false;
+    }
+    notEmpty.notify();
+    return true;
+}
+
+/******************************************************************************
+ * @brief boundedqueue::enqueue - Enqueues, parking while the ring is full
+ * @param val - the value being enqueued
+ * @return none
+ *****************************************************************************/
+void boundedqueue::enqueue(int val)
+{
+    EC_Wait_For(notFull, [this, val]() { return ring.try_enqueue(val) ? 0 : -2; }, NULL);
+    notEmpty.notify();
+}
+
+/******************************************************************************
+ * @brief boundedqueue::dequeue - Takes the oldest value if there is one
+ * @param none
+ * @return int - the value or -2 == EMPTY
+ *****************************************************************************/
+int boundedqueue::dequeue()
+{
+    int val;
+    if (!ring.try_dequeue(val))
+    {
+        return -2;
+    }
+    Drained();
+    return val;
+}
+
+/******************************************************************************
+ * @brief boundedqueue::dequeue_wait - Like dequeue, parking while the ring is
+ *                                     empty
+ * @param timeout - how long to wait, NULL to wait for ever
+ * @return int - the value or -2 if nothing arrived in time
+ *****************************************************************************/
+int boundedqueue::dequeue_wait(const struct timespec * timeout)
+{
+    return EC_Wait_For(notEmpty, [this]() { return dequeue(); }, timeout);
+}
+
+/******************************************************************************
+ * @brief boundedqueue::try_enqueue_batch - Enqueues values until the ring is
+ *                                          full, waking consumers once
+ * @param vals  - the values, in queue order
+ *        count - how many
+ * @return size_t - how many were enqueued
+ *****************************************************************************/
+size_t boundedqueue::try_enqueue_batch(const int * vals, size_t count)
+{
+    size_t done = 0;
+    while (done < count && ring.try_enqueue(vals[done]))
+    {
+        ++done;
+    }
+    if (done != 0)
+    {
+        notEmpty.notify(done);
+    }
+    return done;
+}
+
+/******************************************************************************
+ * @brief boundedqueue::enqueue_batch - Enqueues all the values, parking
+ *                                      whenever the ring is full
+ * @param vals  - the values, in queue order
+ *        count - how many
+ * @return none
+ *****************************************************************************/
+void boundedqueue::enqueue_batch(const int * vals, size_t count)
+{
+    size_t done = try_enqueue_batch(vals, count);
+    while (done < count)
+    {
+        enqueue(vals[done++]);
+        done += try_enqueue_batch(vals + done, count - done);
+    }
+}
+
+/******************************************************************************
+ * @brief boundedqueue::dequeue_batch - Takes up to count values
+ * @param vals  - where the values go, oldest first
+ *        count - room in vals
+ * @return size_t - how many were dequeued, 0 if the ring is empty
+ *****************************************************************************/
+size_t boundedqueue::dequeue_batch(int * vals, size_t count)
+{
+    size_t done = 0;
+    while (done < count && ring.try_dequeue(vals[done]))
+    {
+        ++done;
+    }
+    if (done != 0)
+    {
+        Drained();
+    }
+    return done;
+}
+
+void boundedqueue::report()
+{
+    printf("Bounded capacity: %zu\n", ring.capacity());
+    printf("Producers ");
+    notFull.report();
+    printf("Consumers ");
+    notEmpty.report();
+}
@@ -0,0 +1,46 @@
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+#include <limits.h>
+#include <time.h>
+#include "ringqueue.h"
+#include "eventcount.h"
+
+using namespace std;
+
+/******************************************************************************
+ * Bounded Blocking Queue
+ * The MPMC ring with an eventcount on each side, so memory stays at the
+ * ring's capacity however far the consumers fall behind. An enqueue that
+ * finds the ring full spins briefly and then parks, which is the
+ * backpressure. Parked producers are all woken together once dequeues have
+ * drained the ring to half, rather than one per freed slot, so a full ring
+ * costs one wake syscall per half ring instead of one per element. A
+ * dequeue_wait parks on an empty ring and is woken by the next enqueue.
+ * Either side only pays a syscall when the other side has somebody parked.
+ * The try_ variants never block.
+ *****************************************************************************/
+class boundedqueue
+{
+public:
+    boundedqueue(size_t capacity);
+    void enqueue(int val);
+    bool try_enqueue(int val);
+    int dequeue();
+    int dequeue_wait(const struct timespec * timeout);
+    void enqueue_batch(const int * vals, size_t count);
+    size_t try_enqueue_batch(const int * vals, size_t count);
+    size_t dequeue_batch(int * vals, size_t count);
+    size_t capacity();
+    void report();
+private:
+    ringqueue ring;
+    eventcount notFull;         // Producers park here
+    char pad0[CACHE_LINE - sizeof(eventcount) % CACHE_LINE];
+    eventcount notEmpty;        // Consumers park here
+    void Drained();
+};
+
+#endif
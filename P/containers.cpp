@@ -5,9 +5,35 @@
  *          Treiber Stack              : treiber
  *          Michael and Scott Queue    : ms
  *          Elimination                : e_sgl or e_t
- *          Flat-Combining Stack/Queue : fc
+ *          Elimination Backoff Stack  : elim
+ *          Flat-Combining Stack/Queue : fcstack or fcqueue
  *          Baskets Queue              : basket
+ *          Bounded MPMC Ring Queue    : ring
+ *          Fetch-and-Add Array Queue  : faa
+ *          Wait-Free Queue            : wfq
+ *          Relaxed FIFO MultiQueue    : mq
+ *          Work-Stealing Deque        : wsdeque
+ *          Skiplist Priority Queue    : pq, or sglpq for the SGL baseline
+ *          Bounded Blocking Queue     : bounded
+ *          Intrusive Treiber/MS       : itreiber or ims
+ *          Typed Treiber/MS/SGL       : gtreiber, gms, gsglstack or gsglqueue
+ *          Inter-process MS Queue     : shm (forked producers and consumers)
+ *          Durable Two-Lock Queue     : durable
+ *          SPSC Ring (paired threads) : spsc, or ms with --pairs
  * @run make all; ./containers -t <# threads> -l <# loops/iterations> <above>
+ *                  [--reclaim=hp|ebr|none] [--alloc=pool|new] [--capacity=N]
+ *                  [--pairs] [--batch=N] (batches: treiber, ms, spsc; commits: durable)
+ *                  [--drain=one|all] (treiber, ms)
+ *                  [--policy=seqcst|acqrel|seqcst_padded|acqrel_padded] (treiber, ms)
+ *                  [--backoff=none|exp|yield] [--backoff-cap=N]
+ *                  [--shards=N] (mq)
+ *                  [--segment=N] (faa)
+ *                  [--producers=N] [--wait=poll|park] (ms, basket, bounded)
+ *                  [--payload=64|128|256|512] [--wrapped] (itreiber, ims)
+ *                  [--payload=4|64|128|256|512] (gtreiber, gms, gsglstack, gsglqueue)
+ *                  [--producers=N] [--capacity=N] [--shm=/NAME] (shm)
+ *                  [--batch=N] [--file=PATH] (durable)
+ *                  [--tlcache=N] [--staleness=N] (treiber, elim)
  * @author Brandon Lewien
  * @version 1.0
  ******************************************************************************
@@ -43,9 +69,32 @@
 #include "basketqueue.h"
 #include "msqueue.h"
 #include "eliminationstack.h"
+#include "flatcombining.h"
+#include "ringqueue.h"
+#include "spscqueue.h"
+#include "faaqueue.h"
+#include "wfqueue.h"
+#include "multiqueue.h"
+#include "wsdeque.h"
+#include "skiplistpq.h"
+#include "boundedqueue.h"
+#include "intrusive.h"
+#include "typed.h"
+#include "shmqueue.h"
+#include "durablequeue.h"
+#include "tlcache.h"
+#include "policy.h"
+#include "backoff.h"
 
 #include <string.h> // strcmp
 #include <stdio.h>
+#include <sys/resource.h> // getrusage
+#include <sched.h>        // sched_yield
+#include <sys/mman.h>     // mmap
+#include <sys/wait.h>     // waitpid
+#include <unistd.h>       // fork
+#include <signal.h>       // kill
+#include <fcntl.h>        // open
 
 using namespace std;
 
@@ -61,18 +110,84 @@ typedef enum
     SGL_S_e, 
     SGL_Q_e,
     TREIBER_e,
+    TREIBER_BATCH_e,
+    TREIBER_DRAIN_e,
+    TREIBER_POLICY_e,
     ESGL_e,
     ET_e,
     BASKET_e,
-    MS_e
+    BASKET_WAIT_e,
+    MS_e,
+    MS_BATCH_e,
+    MS_DRAIN_e,
+    MS_POLICY_e,
+    MS_WAIT_e,
+    ELIM_e,
+    FC_S_e,
+    FC_Q_e,
+    RING_e,
+    SPSC_e,
+    FAA_e,
+    WFQ_e,
+    MQ_e,
+    WSDEQUE_e,
+    PQ_e,
+    SGL_PQ_e,
+    BOUNDED_e,
+    ITREIBER_e,
+    IMS_e,
+    TYPED_TREIBER_e,
+    TYPED_MS_e,
+    TYPED_SGL_S_e,
+    TYPED_SGL_Q_e,
+    SHM_e,
+    DURABLE_e,
+    TLCACHE_e
 }test;
 
 int numberThreads = 0;  // Globally defined, set in main
 int numberLoops   = 0;  // Globally defined, set in main but divided by the number of threads
 atomic<int> missed (0); // Self tracker for the Elimination stack
+atomic<unsigned long> elimEmpty (0);    // Pops Elim_ThreadHandler found the stack empty on
+size_t ringCapacity = RING_CAPACITY;    // Set by --capacity
+atomic<unsigned long> ringFull (0);     // Times an enqueue found the ring full
+atomic<long long> ringTaken (0);        // Elements Ring_ThreadHandler dequeued
+atomic<long long> ringSum (0);          // and what they add up to
+atomic<long long> queueTaken (0);       // Elements Queue_ThreadHandler dequeued
+atomic<long long> batchTaken (0);       // Elements the batch handlers took back out
+atomic<long long> queueSum (0);         // and what they add up to
+atomic<long> payloadsReleased (0);      // Hooks imsqueue gave back through Payload_Release
+bool pairMode = false;                  // Set by --pairs, ms runs producer/consumer pairs
+int batchSize = 1;                      // Set by --batch, elements per batch operation
+bool drainAll = false;                  // Set by --drain=all, one pop_all/dequeue_all per thread
+vector<int> * drained = NULL;           // Set by the drain tests, what pop_all/dequeue_all took
+pthread_mutex_t drainedLock = PTHREAD_MUTEX_INITIALIZER;
+int mqShards = 0;                       // Set by --shards, 0 is MQ_SHARDS_PER_THREAD per thread
+int faaSegment = FAA_NODE_SIZE;         // Set by --segment, slots per faa segment
+const char * shmName = NULL;            // Set by --shm, NULL is an anonymous memfd region
+const char * durablePath = NULL;        // Set by --file, NULL is a scratch file removed afterwards
+size_t tlcacheSize = 0;                 // Set by --tlcache, 0 runs treiber and elim without one
+size_t tlcacheStaleness = TLC_STALENESS;// Set by --staleness
+int producerCount = 0;                  // Set by --producers, ms and basket run this many producers
+bool parkWait = true;                   // Set by --wait, idle consumers park (or poll)
+int payloadSize = 64;                   // Set by --payload, bytes per itreiber/ims/typed element
+bool wrappedPayload = false;            // Set by --wrapped, payload indices go through tstack/msqueue
 
 struct timespec start, endTime; 
 
+/******************************************************************************
+ * @brief Harness_Random - xorshift, cheap enough not to show in the timings
+ * @param seed - the caller's state, never 0
+ * @return unsigned - the next number
+ *****************************************************************************/
+static inline unsigned Harness_Random(unsigned * seed)
+{
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 17;
+    *seed ^= *seed << 5;
+    return *seed;
+}
+
 /******************************************************************************
  * @brief _ThreadHandler - Interface between threads and library.
  *                         Back to Back and All then All are used.
@@ -131,9 +246,26 @@ void * SGL_Queue_ThreadHandler(void * queue)
     }
 #endif 
 }
+/******************************************************************************
+ * @brief Drain_Keep - Adds what one pop_all/dequeue_all took to drained
+ * @param vals - the values
+ * @return none
+ *****************************************************************************/
+static void Drain_Keep(const vector<int> & vals)
+{
+    pthread_mutex_lock(&drainedLock);
+    drained->insert(drained->end(), vals.begin(), vals.end());
+    pthread_mutex_unlock(&drainedLock);
+}
+/******************************************************************************
+ * The Treiber and MS handlers are templates over the container so that every
+ * --policy instantiation runs the very same workload. Under --drain=all the
+ * values are only collected when a test asks for them through drained.
+ *****************************************************************************/ 
+template <class S>
 void * Treiber_ThreadHandler(void * object)
 {
-    tstack * objectC = (tstack *)object;
+    S * objectC = (S *)object;
 #ifdef BACK_TO_BACK
     for (int iterations = 0; iterations < numberLoops; ++iterations)
     {
@@ -145,58 +277,282 @@ void * Treiber_ThreadHandler(void * object)
     {
         objectC->push(iterations);
     }
-    for (int iterations = 0; iterations < numberLoops; ++iterations)
+    if (drainAll)
     {
-        int val = (*objectC).pop();
-        // printf("Treiber.Pop:%d\n", val);
+        vector<int> vals;
+        objectC->pop_all((drained != NULL) ? &vals : NULL);
+        if (drained != NULL)
+        {
+            Drain_Keep(vals);
+        }
+    }
+    else
+    {
+        for (int iterations = 0; iterations < numberLoops; ++iterations)
+        {
+            int val = (*objectC).pop();
+            // printf("Treiber.Pop:%d\n", val);
+        }
     }
 #endif 
     // printf("Treiber Thread Exiting\n");
 }
+/******************************************************************************
+ * @brief MS_Drain - Dequeues until the queue is empty, one element at a time
+ *                   or with a single dequeue_all under --drain=all
+ * @param objectC - the queue
+ * @return none
+ *****************************************************************************/
+template <class Q>
+static void MS_Drain(Q * objectC)
+{
+    if (drainAll)
+    {
+        vector<int> vals;
+        objectC->dequeue_all((drained != NULL) ? &vals : NULL);
+        if (drained != NULL)
+        {
+            Drain_Keep(vals);
+        }
+        return;
+    }
+    int val = 0;
+    while(val != -2)
+    {
+        val = objectC->dequeue();
+        // printf("MS-DE:%d\n", val);
+    }
+}
+template <class Q>
 void * MS_ThreadHandler(void * object)
 {
-    msqueue * objectC = (msqueue *)object;
+    Q * objectC = (Q *)object;
 #ifdef BACK_TO_BACK
     for (int iterations = 0; iterations < numberLoops; ++iterations)
     {
         objectC->enqueue(iterations);
         objectC->dequeue();
     }
-    int val = 0;
-    while(val != -2)
+    MS_Drain(objectC);
+#else   
+    for (int iterations = 0; iterations < numberLoops; ++iterations)
     {
-        val = (*objectC).dequeue();
-        // printf("MS-DE:%d\n", val);
+        objectC->enqueue(iterations);
     }
-#else   
+    MS_Drain(objectC);
+#endif 
+}
+/******************************************************************************
+ * @brief Batch_Count - Size of the next batch
+ * @param done  - elements already moved
+ *        total - elements to move
+ * @return int - batchSize, or what is left if that is less
+ *****************************************************************************/ 
+static int Batch_Count(int done, int total)
+{
+    return (total - done < batchSize) ? total - done : batchSize;
+}
+/******************************************************************************
+ * --batch=N versions of the Treiber and MS workloads, the same elements
+ * moved N at a time with one CAS per batch. What the pops and dequeues
+ * report taking goes into batchTaken.
+ *****************************************************************************/ 
+template <class S>
+void * Treiber_Batch_ThreadHandler(void * object)
+{
+    S * objectC = (S *)object;
+    int vals[batchSize];
+    long long taken = 0;
+    for (int iterations = 0; iterations < numberLoops; iterations += batchSize)
+    {
+        int count = Batch_Count(iterations, numberLoops);
+        for (int i = 0; i < count; ++i)
+        {
+            vals[i] = iterations + i;
+        }
+        objectC->push_batch(vals, count);
+#ifdef BACK_TO_BACK
+        taken += objectC->pop_batch(vals, count);
+#endif 
+    }
+#ifndef BACK_TO_BACK
+    if (drainAll)
+    {
+        taken += objectC->pop_all(NULL);
+    }
+    else
+    {
+        for (int iterations = 0; iterations < numberLoops; iterations += batchSize)
+        {
+            taken += objectC->pop_batch(vals, Batch_Count(iterations, numberLoops));
+        }
+    }
+#endif 
+    batchTaken += taken;
+    return NULL;
+}
+template <class Q>
+void * MS_Batch_ThreadHandler(void * object)
+{
+    Q * objectC = (Q *)object;
+    int vals[batchSize];
+    long long taken = 0;
+    for (int iterations = 0; iterations < numberLoops; iterations += batchSize)
+    {
+        int count = Batch_Count(iterations, numberLoops);
+        for (int i = 0; i < count; ++i)
+        {
+            vals[i] = iterations + i;
+        }
+        objectC->enqueue_batch(vals, count);
+#ifdef BACK_TO_BACK
+        taken += objectC->dequeue_batch(vals, count);
+#endif 
+    }
+    if (drainAll)
+    {
+        taken += objectC->dequeue_all(NULL);
+    }
+    size_t got;
+    while ((got = objectC->dequeue_batch(vals, batchSize)) != 0)
+    {
+        taken += got;
+    }
+    batchTaken += taken;
+    return NULL;
+}
+/******************************************************************************
+ * faa and wfq run the MS workload through one handler, MS_ThreadHandler
+ * would want a dequeue_all they do not have. What comes out is counted and
+ * added up for the tests.
+ *****************************************************************************/ 
+template <class Q>
+void * Queue_ThreadHandler(void * object)
+{
+    Q * objectC = (Q *)object;
+    long long taken = 0;
+    long long sum = 0;
+    int val;
     for (int iterations = 0; iterations < numberLoops; ++iterations)
     {
         objectC->enqueue(iterations);
+#ifdef BACK_TO_BACK
+        if ((val = objectC->dequeue()) != -2)
+        {
+            ++taken;
+            sum += val;
+        }
+#endif 
     }
-    int val = 0;
-    while(val != -2)
+    while ((val = objectC->dequeue()) != -2)
     {
-        val = objectC->dequeue();
-        // printf("MS-DE:%d\n", val);
+        ++taken;
+        sum += val;
+    }
+    queueTaken += taken;
+    queueSum += sum;
+    return NULL;
+}
+/******************************************************************************
+ * The multiqueue runs the MS workload too. Each thread keeps the stamps of
+ * what it dequeued and hands them over at the end, for the rank error.
+ *****************************************************************************/ 
+struct mqStruct
+{
+    multiqueue * mq;
+    vector<mq_stamps> * stamps;
+    pthread_mutex_t lock;
+};
+
+void * MQ_ThreadHandler(void * object)
+{
+    mqStruct * objectC = (mqStruct *)object;
+    vector<mq_stamps> local;
+    mq_stamps stamps;
+    for (int iterations = 0; iterations < numberLoops; ++iterations)
+    {
+        objectC->mq->enqueue(iterations);
+#ifdef BACK_TO_BACK
+        if (objectC->mq->dequeue(&stamps) != -2)
+        {
+            local.push_back(stamps);
+        }
+#endif 
     }
+    while (objectC->mq->dequeue(&stamps) != -2)
+    {
+        local.push_back(stamps);
+    }
+    pthread_mutex_lock(&objectC->lock);
+    objectC->stamps->insert(objectC->stamps->end(), local.begin(), local.end());
+    pthread_mutex_unlock(&objectC->lock);
+    return NULL;
+}
+/******************************************************************************
+ * Priority queues - every thread inserts numberLoops random keys and then
+ * deletes the minimum until the queue is empty. The skiplist and the SGL
+ * std::priority_queue baseline run the very same workload.
+ *****************************************************************************/ 
+#define PQ_KEY_MASK 0x3FFFFFFF  // Keys stay well below PQ_TAIL_KEY
+
+void * PQ_ThreadHandler(void * object)
+{
+    skiplistpq * objectC = (skiplistpq *)object;
+    unsigned seed = (unsigned)(size_t)&seed | 1;
+    for (int iterations = 0; iterations < numberLoops; ++iterations)
+    {
+        objectC->insert(Harness_Random(&seed) & PQ_KEY_MASK);
+#ifdef BACK_TO_BACK
+        objectC->delete_min();
+#endif 
+    }
+    while (objectC->delete_min() != -2)
+    {
+    }
+    return NULL;
+}
+
+void * SGL_PQ_ThreadHandler(void * pq)
+{
+    sglPQStruct * pqTC = (sglPQStruct *)pq;
+    unsigned seed = (unsigned)(size_t)&seed | 1;
+    for (int iterations = 0; iterations < numberLoops; ++iterations)
+    {
+        SGL_PQ_Insert(pqTC->minPQ, Harness_Random(&seed) & PQ_KEY_MASK);
+#ifdef BACK_TO_BACK
+        SGL_PQ_Delete_Min(pqTC->minPQ);
 #endif 
+    }
+    while (SGL_PQ_Delete_Min(pqTC->minPQ) != -2)
+    {
+    }
+    return NULL;
 }
 /******************************************************************************
- * Refer to writeup for Basket queue.
+ * Refer to writeup for Basket queue. It runs the MS workload.
  *****************************************************************************/ 
 void * Basket_ThreadHandler(void * queueInput)
 {
     queue_t * queue = (queue_t *)queueInput;
+#ifdef BACK_TO_BACK
     for (int iterations = 0; iterations < numberLoops; ++iterations)
     {
         Basket_Enqueue(queue, iterations);
+        Basket_Dequeue(queue);
     }
+#else
+    for (int iterations = 0; iterations < numberLoops; ++iterations)
+    {
+        Basket_Enqueue(queue, iterations);
+    }
+#endif 
     int temp = 0;
     while (temp != -2)
     {
         temp = Basket_Dequeue(queue);
-        printf("Basket-DE:%d\n", temp);
+        // printf("Basket-DE:%d\n", temp);
     }
+    return NULL;
 }
 /******************************************************************************
  * The Elimination threads are a bit confusing partly because one performs
@@ -307,126 +663,2005 @@ void * E_Treiber_Stack_ThreadHandler(void * stack)
 #endif
     // printf("Missed %d\n", (int)missed);
 }
-// Basic "Does it Run?" Tests
-static bool test1(int * counter, int which, int numberThreadsLocal, int numIter)
+/******************************************************************************
+ * The elimination backoff stack runs the Treiber workload unchanged so the
+ * two can be timed against each other. Every pop follows this thread's own
+ * pushes, so none of them may find the stack empty.
+ *****************************************************************************/ 
+void * Elim_ThreadHandler(void * object)
 {
-    numberLoops = numIter;
-    pthread_t threads[numberThreadsLocal]; 
-
-    switch(which)
+    elimstack * objectC = (elimstack *)object;
+    unsigned long empty = 0;
+#ifdef BACK_TO_BACK
+    for (int iterations = 0; iterations < numberLoops; ++iterations)
     {
-        case(SGL_S_e):
+        objectC->push(iterations);
+        empty += (objectC->pop() == -2);
+    }
+#else
+    for (int iterations = 0; iterations < numberLoops; ++iterations)
+    {
+        objectC->push(iterations);
+    }
+    for (int iterations = 0; iterations < numberLoops; ++iterations)
+    {
+        empty += (objectC->pop() == -2);
+    }
+#endif 
+    elimEmpty += empty;
+    return NULL;
+}
+/******************************************************************************
+ * Flat combining runs the SGL workload, the combiner takes the place of
+ * singleGlobalLock.
+ *****************************************************************************/ 
+void * FC_Stack_ThreadHandler(void * stack)
+{
+    fcstack * stackTC = (fcstack *)stack;
+#ifdef BACK_TO_BACK
+    for (int iterations = 0; iterations < numberLoops; ++iterations)
+    {
+        stackTC->push(iterations);
+        stackTC->pop();
+    }
+#else
+    for (int iterations = 0; iterations < numberLoops; ++iterations)
+    {
+        stackTC->push(iterations);
+    }
+#endif 
+    while (stackTC->pop() != -2)
+    {
+    }
+    return NULL;
+}
+void * FC_Queue_ThreadHandler(void * queue)
+{
+    fcqueue * queueTC = (fcqueue *)queue;
+#ifdef BACK_TO_BACK
+    for (int iterations = 0; iterations < numberLoops; ++iterations)
+    {
+        queueTC->enqueue(iterations);
+        queueTC->dequeue();
+    }
+#else
+    for (int iterations = 0; iterations < numberLoops; ++iterations)
+    {
+        queueTC->enqueue(iterations);
+    }
+#endif 
+    while (queueTC->dequeue() != -2)
+    {
+    }
+    return NULL;
+}
+/******************************************************************************
+ * The ring runs the MS workload, but it is bounded: when an enqueue finds it
+ * full the thread dequeues one element to make room instead of waiting on
+ * threads that may all be enqueueing too. Everything it dequeues, either
+ * way, is counted and added up for the test to check.
+ *****************************************************************************/ 
+void * Ring_ThreadHandler(void * object)
+{
+    ringqueue * objectC = (ringqueue *)object;
+    unsigned long full = 0;
+    long long taken = 0;
+    long long sum = 0;
+    int val;
+    for (int iterations = 0; iterations < numberLoops; ++iterations)
+    {
+        while (!objectC->try_enqueue(iterations))
         {
-            // SGL Stack
-            std::stack<int> lifoStack;
-            sglStackStruct stackStruct;
-            stackStruct.lifoStack = &lifoStack;
-
-            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
-            {
-                pthread_create(&threads[numThreads], NULL, SGL_Stack_ThreadHandler, &stackStruct); 
-            }
-            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            ++full;
+            if (objectC->try_dequeue(val))
             {
-                pthread_join(threads[numThreads], NULL); 
+                ++taken;
+                sum += val;
             }
-            break;
         }
-        case(SGL_Q_e):
+#ifdef BACK_TO_BACK
+        if (objectC->try_dequeue(val))
         {
-            // SGL Queue
-            std::queue<int> fifoQueue;
-            sglQueueStruct queueStruct;
-            queueStruct.fifoQueue = &fifoQueue;
-            queueStruct.loops = numberLoops;
+            ++taken;
+            sum += val;
+        }
+#endif 
+    }
+    while (objectC->try_dequeue(val))
+    {
+        ++taken;
+        sum += val;
+    }
+    ringFull += full;
+    ringTaken += taken;
+    ringSum += sum;
+    return NULL;
+}
+/******************************************************************************
+ * Paired runs - half the threads only produce and half only consume, each
+ * pair with a queue of its own. The SPSC ring needs this shape, and ms is run
+ * the same way (--pairs) so the two can be compared. A side that finds its
+ * queue full or empty pauses, yielding now and then so that its partner gets
+ * the core when there are more threads than cores. Each queue is FIFO with
+ * one producer, so the consumer must see 0, 1, 2, ... in order. The first
+ * value out of place sets failed, which stops both sides.
+ *****************************************************************************/ 
+struct pairStruct
+{
+    spscqueue * spsc;
+    msqueue   * ms;
+    int items;
+    atomic<bool> failed;
+};
 
-            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
-            {
-                pthread_create(&threads[numThreads], NULL, SGL_Queue_ThreadHandler, &queueStruct); 
-            }
-            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
-            {
-                pthread_join(threads[numThreads], NULL); 
-            } 
-            break;
+static void Pair_Wait(int * spins)
+{
+    __builtin_ia32_pause();
+    if (++(*spins) % 64 == 0)
+    {
+        sched_yield();
+    }
+}
+
+void * SPSC_Producer_ThreadHandler(void * pair)
+{
+    pairStruct * pairC = (pairStruct *)pair;
+    int vals[batchSize];
+    int spins = 0;
+    for (int iterations = 0; iterations < pairC->items; iterations += batchSize)
+    {
+        int count = Batch_Count(iterations, pairC->items);
+        for (int i = 0; i < count; ++i)
+        {
+            vals[i] = iterations + i;
         }
-        case(TREIBER_e):
+        int pushed = 0;
+        while (pushed < count)
         {
-            // Treiber Stack
-            tstack TreiberStack;
-            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            if (count == 1)
             {
-                pthread_create(&threads[numThreads], NULL, Treiber_ThreadHandler, &TreiberStack); 
+                pushed += pairC->spsc->try_push(vals[0]);
             }
-            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
-            {
-                pthread_join(threads[numThreads], NULL); 
-            } 
-            break;
-        }
-        case(MS_e):
-        {
-            // MS queue
-            msqueue msqueueObject;  // Create the Object
-            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            else
             {
-                pthread_create(&threads[numThreads], NULL, MS_ThreadHandler, &msqueueObject); 
+                pushed += pairC->spsc->push_batch(vals + pushed, count - pushed);
             }
-            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            if (pushed < count)
             {
-                pthread_join(threads[numThreads], NULL); 
+                if (pairC->failed.load(memory_order_relaxed))
+                {
+                    return NULL;
+                }
+                Pair_Wait(&spins);
             }
-            break;
         }
-        case(BASKET_e):
+    }
+    return NULL;
+}
+void * SPSC_Consumer_ThreadHandler(void * pair)
+{
+    pairStruct * pairC = (pairStruct *)pair;
+    int vals[batchSize];
+    int spins = 0;
+    int received = 0;
+    while (received < pairC->items)
+    {
+        int got;
+        if (batchSize == 1)
         {
-            // Basket queue
-            queue_t * queueInput = new queue_t;
-            init_queue(queueInput);
+            got = pairC->spsc->try_pop(vals[0]);
+        }
+        else
+        {
+            got = pairC->spsc->pop_batch(vals, batchSize);
+        }
+        if (got == 0)
+        {
+            Pair_Wait(&spins);
+        }
+        for (int i = 0; i < got; ++i)
+        {
+            if (vals[i] != received + i)
+            {
+                pairC->failed.store(true);
+                return NULL;
+            }
+        }
+        received += got;
+    }
+    return NULL;
+}
+void * MS_Producer_ThreadHandler(void * pair)
+{
+    pairStruct * pairC = (pairStruct *)pair;
+    int vals[batchSize];
+    for (int iterations = 0; iterations < pairC->items; iterations += batchSize)
+    {
+        int count = Batch_Count(iterations, pairC->items);
+        if (count == 1)
+        {
+            pairC->ms->enqueue(iterations);
+            continue;
+        }
+        for (int i = 0; i < count; ++i)
+        {
+            vals[i] = iterations + i;
+        }
+        pairC->ms->enqueue_batch(vals, count);
+    }
+    return NULL;
+}
+void * MS_Consumer_ThreadHandler(void * pair)
+{
+    pairStruct * pairC = (pairStruct *)pair;
+    int vals[batchSize];
+    int spins = 0;
+    int received = 0;
+    while (received < pairC->items)
+    {
+        int got;
+        if (batchSize == 1)
+        {
+            vals[0] = pairC->ms->dequeue();
+            got = (vals[0] == -2) ? 0 : 1;
+        }
+        else
+        {
+            got = pairC->ms->dequeue_batch(vals, batchSize);
+        }
+        if (got == 0)
+        {
+            Pair_Wait(&spins);
+        }
+        for (int i = 0; i < got; ++i)
+        {
+            if (vals[i] != received + i)
+            {
+                pairC->failed.store(true);
+                return NULL;
+            }
+        }
+        received += got;
+    }
+    return NULL;
+}
+
+/******************************************************************************
+ * @brief Run_Pairs - Runs numberPairs producer/consumer pairs to completion.
+ *                    Each pair moves twice numberLoops elements, the same
+ *                    total as two threads of the other workloads.
+ * @param spsc        - SPSC rings if true, MS queues otherwise
+ *        numberPairs - how many pairs
+ * @return bool - true if every consumer got its producer's values in order
+ *****************************************************************************/
+static bool Run_Pairs(bool spsc, int numberPairs)
+{
+    pthread_t threads[2 * numberPairs];
+    pairStruct pairs[numberPairs];
+    for (int pair = 0; pair < numberPairs; ++pair)
+    {
+        pairs[pair].spsc = spsc ? new spscqueue(SPSC_CAPACITY) : NULL;
+        pairs[pair].ms = spsc ? NULL : new msqueue;
+        pairs[pair].items = 2 * numberLoops;
+        pairs[pair].failed.store(false);
+        pthread_create(&threads[2 * pair], NULL,
+                       spsc ? SPSC_Producer_ThreadHandler : MS_Producer_ThreadHandler, &pairs[pair]);
+        pthread_create(&threads[2 * pair + 1], NULL,
+                       spsc ? SPSC_Consumer_ThreadHandler : MS_Consumer_ThreadHandler, &pairs[pair]);
+    }
+    for (int numThreads = 0; numThreads < 2 * numberPairs; ++numThreads)
+    {
+        pthread_join(threads[numThreads], NULL); 
+    }
+    bool passed = true;
+    for (int pair = 0; pair < numberPairs; ++pair)
+    {
+        passed = passed && !pairs[pair].failed.load();
+        delete pairs[pair].spsc;
+        delete pairs[pair].ms;
+    }
+    return passed;
+}
+/******************************************************************************
+ * Work stealing - every thread has a deque of its own. It pushes its
+ * elements, pops them back off the bottom until the deque is empty, then
+ * steals from random victims until every element of every thread has been
+ * taken by somebody. remaining counts what is still in any deque, so a lost
+ * element would keep the thieves going and a duplicate drives it negative.
+ *****************************************************************************/ 
+struct stealStruct
+{
+    wsdeque ** deques;
+    int count;
+    atomic<int> nextId;
+    atomic<long> remaining;
+    atomic<unsigned long> stolen;
+    atomic<unsigned long> aborts;
+};
+
+void * WS_ThreadHandler(void * object)
+{
+    stealStruct * objectC = (stealStruct *)object;
+    int id = objectC->nextId.fetch_add(1);
+    wsdeque * own = objectC->deques[id];
+    long done = 0;
+    for (int iterations = 0; iterations < numberLoops; ++iterations)
+    {
+        own->push(iterations);
+#ifdef BACK_TO_BACK
+        if (own->pop() != -2)
+        {
+            ++done;
+        }
+#endif 
+    }
+    while (own->pop() != -2)
+    {
+        ++done;
+    }
+    objectC->remaining.fetch_sub(done);
+    // Out of work, steal
+    unsigned long stolen = 0;
+    unsigned long aborts = 0;
+    unsigned seed = id + 1;
+    int spins = 0;
+    while (objectC->remaining.load(memory_order_relaxed) > 0)
+    {
+        int val = objectC->deques[Harness_Random(&seed) % objectC->count]->steal();
+        if (val == WSD_ABORT)
+        {
+            ++aborts;
+        }
+        else if (val != -2)
+        {
+            ++stolen;
+            objectC->remaining.fetch_sub(1);
+        }
+        else
+        {
+            Pair_Wait(&spins);
+        }
+    }
+    objectC->stolen += stolen;
+    objectC->aborts += aborts;
+    return NULL;
+}
+
+/******************************************************************************
+ * @brief Run_Steal - Runs the work-stealing workload to completion
+ * @param numberThreadsLocal - how many threads, one deque each
+ *        capacity           - each deque's starting slot count
+ *        report             - print the steal counts when true
+ * @return bool - true if every element was taken exactly once
+ *****************************************************************************/
+static bool Run_Steal(int numberThreadsLocal, size_t capacity, bool report)
+{
+    pthread_t threads[numberThreadsLocal];
+    wsdeque * deques[numberThreadsLocal];
+    stealStruct threadPassIn;
+    threadPassIn.deques = deques;
+    threadPassIn.count = numberThreadsLocal;
+    threadPassIn.nextId.store(0);
+    threadPassIn.remaining.store((long)numberLoops * numberThreadsLocal);
+    threadPassIn.stolen.store(0);
+    threadPassIn.aborts.store(0);
+    for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+    {
+        deques[numThreads] = new wsdeque(capacity);
+    }
+    for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+    {
+        pthread_create(&threads[numThreads], NULL, WS_ThreadHandler, &threadPassIn); 
+    }
+    for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+    {
+        pthread_join(threads[numThreads], NULL); 
+    }
+    size_t grown = 0;
+    for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+    {
+        if (deques[numThreads]->capacity() > grown)
+        {
+            grown = deques[numThreads]->capacity();
+        }
+        delete deques[numThreads];
+    }
+    if (report)
+    {
+        printf("Stolen: %lu of %ld aborts: %lu largest deque: %zu\n", threadPassIn.stolen.load(),
+               (long)numberLoops * numberThreadsLocal, threadPassIn.aborts.load(), grown);
+    }
+    return threadPassIn.remaining.load() == 0;
+}
+/******************************************************************************
+ * Producers and consumers on one queue - the producers split the elements
+ * between them and the consumers take until all of them are gone. An idle
+ * consumer either parks (--wait=park) or keeps polling for -2 (--wait=poll).
+ * The wait is bounded so that consumers notice the end. ms and basket run
+ * fewer producers than consumers; bounded runs more, so that its producers
+ * are the ones held back.
+ *****************************************************************************/ 
+struct waitStruct
+{
+    msqueue * ms;
+    queue_t * basket;
+    boundedqueue * bounded;
+    int items;                  // Per producer
+    atomic<long> remaining;
+};
+
+static const struct timespec waitTimeout = {0, 1000000};
+
+void * Wait_Producer_ThreadHandler(void * object)
+{
+    waitStruct * waitC = (waitStruct *)object;
+    int vals[batchSize];
+    for (int iterations = 0; iterations < waitC->items; iterations += batchSize)
+    {
+        int count = Batch_Count(iterations, waitC->items);
+        for (int i = 0; i < count; ++i)
+        {
+            vals[i] = iterations + i;
+        }
+        if (waitC->ms != NULL)
+        {
+            waitC->ms->enqueue_batch(vals, count);
+        }
+        else if (waitC->basket != NULL)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                Basket_Enqueue(waitC->basket, vals[i]);
+            }
+        }
+        else
+        {
+            waitC->bounded->enqueue_batch(vals, count);
+        }
+    }
+    return NULL;
+}
+
+void * Wait_Consumer_ThreadHandler(void * object)
+{
+    waitStruct * waitC = (waitStruct *)object;
+    int val;
+    int vals[batchSize];
+    while (waitC->remaining.load(memory_order_relaxed) > 0)
+    {
+        long taken;
+        if (waitC->ms != NULL)
+        {
+            val = parkWait ? waitC->ms->dequeue_wait(&waitTimeout) : waitC->ms->dequeue();
+            taken = (val != -2) ? 1 : 0;
+        }
+        else if (waitC->basket != NULL)
+        {
+            val = parkWait ? Basket_Dequeue_Wait(waitC->basket, &waitTimeout) : Basket_Dequeue(waitC->basket);
+            taken = (val != -2) ? 1 : 0;
+        }
+        else
+        {
+            taken = waitC->bounded->dequeue_batch(vals, batchSize);
+            if (taken == 0 && parkWait)
+            {
+                taken = (waitC->bounded->dequeue_wait(&waitTimeout) != -2) ? 1 : 0;
+            }
+        }
+        if (taken != 0)
+        {
+            waitC->remaining.fetch_sub(taken, memory_order_relaxed);
+        }
+    }
+    return NULL;
+}
+
+/******************************************************************************
+ * @brief Run_Waiters - Runs producers and consumers on one queue to
+ *                      completion, numberLoops elements per thread in all
+ * @param which     - MS_WAIT_e, BASKET_WAIT_e or BOUNDED_e
+ *        producers - how many producers
+ *        consumers - how many consumers
+ *        report    - print the park counts and throughput when true
+ * @return bool - true if every element was taken exactly once
+ *****************************************************************************/
+static bool Run_Waiters(int which, int producers, int consumers, bool report)
+{
+    pthread_t threads[producers + consumers];
+    waitStruct threadPassIn;
+    threadPassIn.ms = (which == MS_WAIT_e) ? new msqueue : NULL;
+    threadPassIn.basket = NULL;
+    threadPassIn.bounded = (which == BOUNDED_e) ? new boundedqueue(ringCapacity) : NULL;
+    if (which == BASKET_WAIT_e)
+    {
+        threadPassIn.basket = new queue_t;
+        init_queue(threadPassIn.basket);
+    }
+    threadPassIn.items = numberLoops * (producers + consumers) / producers;
+    threadPassIn.remaining.store((long)threadPassIn.items * producers);
+    for (int numThreads = 0; numThreads < consumers; ++numThreads)
+    {
+        pthread_create(&threads[numThreads], NULL, Wait_Consumer_ThreadHandler, &threadPassIn); 
+    }
+    for (int numThreads = consumers; numThreads < producers + consumers; ++numThreads)
+    {
+        pthread_create(&threads[numThreads], NULL, Wait_Producer_ThreadHandler, &threadPassIn); 
+    }
+    for (int numThreads = 0; numThreads < producers + consumers; ++numThreads)
+    {
+        pthread_join(threads[numThreads], NULL); 
+    }
+    if (report)
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        double seconds = (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1000000000.0;
+        printf("Producers: %d consumers: %d throughput (elements/s): %.0f\n", producers, consumers,
+               (double)threadPassIn.items * producers / seconds);
+    }
+    bool empty;
+    if (threadPassIn.basket != NULL)
+    {
+        empty = Basket_Dequeue(threadPassIn.basket) == -2;
+        if (report)
+        {
+            threadPassIn.basket->ready.report();
+        }
+        destroy_queue(threadPassIn.basket);
+        delete threadPassIn.basket;
+    }
+    else if (threadPassIn.ms != NULL)
+    {
+        empty = threadPassIn.ms->dequeue() == -2;
+        if (report)
+        {
+            threadPassIn.ms->ready.report();
+        }
+        delete threadPassIn.ms;
+    }
+    else
+    {
+        empty = threadPassIn.bounded->dequeue() == -2;
+        if (report)
+        {
+            threadPassIn.bounded->report();
+        }
+        delete threadPassIn.bounded;
+    }
+    return empty && threadPassIn.remaining.load() == 0;
+}
+/******************************************************************************
+ * Intrusive containers - every thread owns numberLoops payloads of N bytes
+ * with a hook at the front. It fills each one in and links its hook into
+ * the container, then takes hooks back out until the container is empty and
+ * reads the payloads it got. --wrapped runs the same payloads through
+ * tstack/msqueue instead, which carry the payload's index in a node of
+ * their own, for the comparison. sum adds up val + 1 of every payload taken.
+ *****************************************************************************/ 
+template <size_t N>
+struct payload
+{
+    ihook hook;     // First, so a hook is its payload
+    int val;
+    char data[N - sizeof(ihook) - sizeof(int)];
+};
+
+struct intrusiveStruct
+{
+    itstack * stack;
+    imsqueue * queue;
+    tstack * wrappedStack;
+    msqueue * wrappedQueue;
+    void * payloads;
+    atomic<int> nextId;
+    atomic<long> sum;
+};
+
+static void Payload_Release(void *)
+{
+    // The payload array outlives the run, only count what comes back
+    payloadsReleased.fetch_add(1, memory_order_relaxed);
+}
+
+template <size_t N>
+static long Intrusive_Take(intrusiveStruct * objectC)
+{
+    payload<N> * p;
+    if (objectC->stack != NULL)
+    {
+        p = (payload<N> *)objectC->stack->pop();
+    }
+    else if (objectC->queue != NULL)
+    {
+        p = (payload<N> *)objectC->queue->dequeue();
+    }
+    else
+    {
+        int index = (objectC->wrappedStack != NULL) ? objectC->wrappedStack->pop() : objectC->wrappedQueue->dequeue();
+        p = (index == -2) ? NULL : (payload<N> *)objectC->payloads + index;
+    }
+    if (p == NULL)
+    {
+        return -1;
+    }
+    long taken = p->val + p->data[sizeof(p->data) - 1];
+    if (objectC->queue != NULL)
+    {
+        objectC->queue->done();
+    }
+    return taken;
+}
+
+template <size_t N>
+void * Intrusive_ThreadHandler(void * object)
+{
+    intrusiveStruct * objectC = (intrusiveStruct *)object;
+    int id = objectC->nextId.fetch_add(1);
+    payload<N> * mine = (payload<N> *)objectC->payloads + id * numberLoops;
+    long sum = 0;
+    long taken;
+    for (int iterations = 0; iterations < numberLoops; ++iterations)
+    {
+        payload<N> * p = &mine[iterations];
+        p->val = iterations;
+        p->data[sizeof(p->data) - 1] = 1;
+        if (objectC->stack != NULL)
+        {
+            objectC->stack->push(&p->hook);
+        }
+        else if (objectC->queue != NULL)
+        {
+            objectC->queue->enqueue(&p->hook);
+        }
+        else if (objectC->wrappedStack != NULL)
+        {
+            objectC->wrappedStack->push(id * numberLoops + iterations);
+        }
+        else
+        {
+            objectC->wrappedQueue->enqueue(id * numberLoops + iterations);
+        }
+#ifdef BACK_TO_BACK
+        taken = Intrusive_Take<N>(objectC);
+        sum += (taken < 0) ? 0 : taken;
+#endif 
+    }
+    while ((taken = Intrusive_Take<N>(objectC)) >= 0)
+    {
+        sum += taken;
+    }
+    objectC->sum += sum;
+    return NULL;
+}
+
+/******************************************************************************
+ * @brief Run_Intrusive - Runs the payload workload to completion
+ * @param queue              - ims if true, itreiber otherwise
+ *        numberThreadsLocal - how many threads
+ * @return bool - true if every payload was taken exactly once
+ *****************************************************************************/
+template <size_t N>
+static bool Run_Intrusive(bool queue, int numberThreadsLocal)
+{
+    pthread_t threads[numberThreadsLocal];
+    intrusiveStruct threadPassIn;
+    threadPassIn.stack = (!queue && !wrappedPayload) ? new itstack : NULL;
+    threadPassIn.queue = (queue && !wrappedPayload) ? new imsqueue(Payload_Release) : NULL;
+    threadPassIn.wrappedStack = (!queue && wrappedPayload) ? new tstack : NULL;
+    threadPassIn.wrappedQueue = (queue && wrappedPayload) ? new msqueue : NULL;
+    threadPassIn.payloads = new payload<N>[numberThreadsLocal * numberLoops];
+    threadPassIn.nextId.store(0);
+    threadPassIn.sum.store(0);
+    payloadsReleased.store(0);
+    for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+    {
+        pthread_create(&threads[numThreads], NULL, Intrusive_ThreadHandler<N>, &threadPassIn); 
+    }
+    for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+    {
+        pthread_join(threads[numThreads], NULL); 
+    }
+    delete threadPassIn.stack;
+    delete threadPassIn.queue;
+    delete threadPassIn.wrappedStack;
+    delete threadPassIn.wrappedQueue;
+    Reclaim_Flush();    // Retired hooks point into the payloads
+    delete[] (payload<N> *)threadPassIn.payloads;
+    // Every payload was the dummy once, the last one comes back through
+    // the destructor. Without a scheme nothing else is released.
+    if (threadPassIn.queue != NULL && reclaimScheme != RECLAIM_NONE_e &&
+        payloadsReleased.load() != (long)numberThreadsLocal * numberLoops)
+    {
+        return false;
+    }
+    return threadPassIn.sum.load() == (long)numberThreadsLocal * numberLoops * (numberLoops + 1) / 2;
+}
+
+static bool Run_Intrusive(bool queue, int numberThreadsLocal)
+{
+    switch (payloadSize)
+    {
+        case(128): return Run_Intrusive<128>(queue, numberThreadsLocal);
+        case(256): return Run_Intrusive<256>(queue, numberThreadsLocal);
+        case(512): return Run_Intrusive<512>(queue, numberThreadsLocal);
+        default:   return Run_Intrusive<64>(queue, numberThreadsLocal);
+    }
+}
+/******************************************************************************
+ * Typed containers - the plain workload, but every element is a move-only
+ * message of N bytes constructed in place, and every thread takes until
+ * the container reports empty. sum adds up val + 1 of every message taken.
+ *****************************************************************************/ 
+template <size_t N>
+struct message
+{
+    int val;
+    char data[N - sizeof(int)];
+    explicit message(int v) : val(v)
+    {
+        data[sizeof(data) - 1] = 1;
+    }
+    message(message &&) = default;
+    message & operator=(message &&) = default;
+    message(const message &) = delete;
+    message & operator=(const message &) = delete;
+    long check() const
+    {
+        return val + data[sizeof(data) - 1];
+    }
+};
+
+template <>
+struct message<4>
+{
+    int val;
+    explicit message(int v) : val(v) {}
+    message(message &&) = default;
+    message & operator=(message &&) = default;
+    message(const message &) = delete;
+    message & operator=(const message &) = delete;
+    long check() const
+    {
+        return val + 1;
+    }
+};
+
+template <class C>
+struct typedStruct
+{
+    C container;
+    atomic<long> sum;
+};
+
+template <class T> static void Typed_Put(typed_tstack<T> * c, int v) { c->emplace(v); }
+template <class T> static void Typed_Put(typed_msqueue<T> * c, int v) { c->emplace(v); }
+template <class T> static void Typed_Put(std::stack<T> * c, int v) { SGL_Stack_Emplace(c, v); }
+template <class T> static void Typed_Put(std::queue<T> * c, int v) { SGL_Queue_Emplace(c, v); }
+template <class T> static bool Typed_Take(typed_tstack<T> * c, T & out) { return c->try_pop(out); }
+template <class T> static bool Typed_Take(typed_msqueue<T> * c, T & out) { return c->try_dequeue(out); }
+template <class T> static bool Typed_Take(std::stack<T> * c, T & out) { return SGL_Stack_Try_Pop(c, out); }
+template <class T> static bool Typed_Take(std::queue<T> * c, T & out) { return SGL_Queue_Try_Dequeue(c, out); }
+
+template <class C, class T>
+void * Typed_ThreadHandler(void * object)
+{
+    typedStruct<C> * objectC = (typedStruct<C> *)object;
+    T out(-1);
+    long sum = 0;
+    for (int iterations = 0; iterations < numberLoops; ++iterations)
+    {
+        Typed_Put(&objectC->container, iterations);
+#ifdef BACK_TO_BACK
+        if (Typed_Take(&objectC->container, out))
+        {
+            sum += out.check();
+        }
+#endif 
+    }
+    while (Typed_Take(&objectC->container, out))
+    {
+        sum += out.check();
+    }
+    objectC->sum += sum;
+    return NULL;
+}
+
+/******************************************************************************
+ * @brief Run_Typed - Runs the typed workload to completion
+ * @param which              - TYPED_TREIBER_e, TYPED_MS_e, TYPED_SGL_S_e or
+ *                             TYPED_SGL_Q_e, at the --payload size
+ *        numberThreadsLocal - how many threads
+ * @return bool - true if every message was taken exactly once
+ *****************************************************************************/
+template <class C, class T>
+static bool Run_Typed_Container(int numberThreadsLocal)
+{
+    pthread_t threads[numberThreadsLocal];
+    typedStruct<C> * threadPassIn = new typedStruct<C>;
+    threadPassIn->sum.store(0);
+    for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+    {
+        pthread_create(&threads[numThreads], NULL, Typed_ThreadHandler<C, T>, threadPassIn); 
+    }
+    for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+    {
+        pthread_join(threads[numThreads], NULL); 
+    }
+    bool passed = threadPassIn->sum.load() == (long)numberThreadsLocal * numberLoops * (numberLoops + 1) / 2;
+    delete threadPassIn;
+    return passed;
+}
+
+template <class T>
+static bool Run_Typed_Payload(int which, int numberThreadsLocal)
+{
+    switch (which)
+    {
+        case(TYPED_TREIBER_e): return Run_Typed_Container<typed_tstack<T>, T>(numberThreadsLocal);
+        case(TYPED_MS_e):      return Run_Typed_Container<typed_msqueue<T>, T>(numberThreadsLocal);
+        case(TYPED_SGL_S_e):   return Run_Typed_Container<std::stack<T>, T>(numberThreadsLocal);
+        default:               return Run_Typed_Container<std::queue<T>, T>(numberThreadsLocal);
+    }
+}
+
+static bool Run_Typed(int which, int numberThreadsLocal)
+{
+    switch (payloadSize)
+    {
+        case(4):   return Run_Typed_Payload< message<4> >(which, numberThreadsLocal);
+        case(128): return Run_Typed_Payload< message<128> >(which, numberThreadsLocal);
+        case(256): return Run_Typed_Payload< message<256> >(which, numberThreadsLocal);
+        case(512): return Run_Typed_Payload< message<512> >(which, numberThreadsLocal);
+        default:   return Run_Typed_Payload< message<64> >(which, numberThreadsLocal);
+    }
+}
+/******************************************************************************
+ * Inter-process queue - producers and consumers are forked processes rather
+ * than threads. Each producer enqueues items values, retrying while the
+ * region is full, and consumers take until remaining reaches zero. Only the
+ * region and this control block are shared between them.
+ *****************************************************************************/ 
+struct shmControl
+{
+    atomic<long> remaining;
+    atomic<long> sum;
+    atomic<bool> abort;         // Set once a child failed, everyone stops
+};
+
+static void Shm_Producer(shmqueue * q, shmControl * control, int items)
+{
+    for (int iterations = 0; iterations < items; ++iterations)
+    {
+        while (!q->enqueue(iterations))
+        {
+            if (control->abort.load(memory_order_relaxed))
+            {
+                return;
+            }
+            sched_yield();
+        }
+    }
+}
+
+static void Shm_Consumer(shmqueue * q, shmControl * control)
+{
+    long sum = 0;
+    while (control->remaining.load(memory_order_relaxed) > 0 &&
+           !control->abort.load(memory_order_relaxed))
+    {
+        int val = q->dequeue();
+        if (val == -2)
+        {
+            sched_yield();
+            continue;
+        }
+        sum += val + 1;
+        control->remaining.fetch_sub(1, memory_order_relaxed);
+    }
+    control->sum.fetch_add(sum);
+}
+
+/******************************************************************************
+ * @brief Run_Processes - Forks producers and consumers on one shared region
+ *                        and waits for all of them, numberLoops elements per
+ *                        process in all. The first child to fail stops the
+ *                        rest, or its missing elements would keep the
+ *                        consumers waiting forever.
+ * @param producers - how many producer processes
+ *        consumers - how many consumer processes
+ *        name      - shm name the children attach to, NULL to have them
+ *                    inherit an anonymous memfd region
+ *        report    - print the throughput and region counts when true
+ * @return bool - true if every element was taken exactly once
+ *****************************************************************************/
+static bool Run_Processes(int producers, int consumers, const char * name, bool report)
+{
+    uint32_t nodes = (ringCapacity > UINT32_MAX / 2) ? UINT32_MAX / 2 : ringCapacity;
+    shmqueue * q = shmqueue::Create(name, nodes);
+    if (q == NULL)
+    {
+        printf("Could not create the shared region\n");
+        return false;
+    }
+    void * shared = mmap(NULL, sizeof(shmControl), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED)
+    {
+        printf("Could not map the control block\n");
+        shmqueue::Detach(q);
+        if (name != NULL)
+        {
+            shmqueue::Unlink(name);
+        }
+        return false;
+    }
+    shmControl * control = (shmControl *)shared;
+    int items = numberLoops * (producers + consumers) / producers;
+    new (&control->remaining) atomic<long>((long)items * producers);
+    new (&control->sum) atomic<long>(0);
+    new (&control->abort) atomic<bool>(false);
+    fflush(stdout);
+    pid_t children[producers + consumers];
+    int forked = 0;
+    bool passed = true;
+    for (; forked < producers + consumers; ++forked)
+    {
+        children[forked] = fork();
+        if (children[forked] < 0)
+        {
+            control->abort.store(true);
+            passed = false;
+            break;
+        }
+        if (children[forked] == 0)
+        {
+            shmqueue * child = q;
+            if (name != NULL)
+            {
+                // Map the region afresh the way an unrelated process would
+                child = shmqueue::Attach(name);
+                if (child == NULL)
+                {
+                    _exit(1);
+                }
+            }
+            if (forked < producers)
+            {
+                Shm_Producer(child, control, items);
+            }
+            else
+            {
+                Shm_Consumer(child, control);
+            }
+            _exit(0);
+        }
+    }
+    // Reap in whatever order they finish, one failure stops the others
+    for (int reaped = 0; reaped < forked; )
+    {
+        int status;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0)
+        {
+            passed = false;
+            break;
+        }
+        int numProcs = 0;
+        while (numProcs < forked && children[numProcs] != pid)
+        {
+            ++numProcs;
+        }
+        if (numProcs == forked)
+        {
+            continue;   // Not one of ours
+        }
+        children[numProcs] = 0;
+        ++reaped;
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            if (passed)
+            {
+                control->abort.store(true);
+                for (int other = 0; other < forked; ++other)
+                {
+                    if (children[other] > 0)
+                    {
+                        kill(children[other], SIGKILL);
+                    }
+                }
+            }
+            passed = false;
+        }
+    }
+    if (report)
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        double seconds = (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1000000000.0;
+        printf("Producers: %d consumers: %d throughput (elements/s): %.0f\n", producers, consumers,
+               (double)items * producers / seconds);
+        q->report();
+    }
+    passed = passed && control->sum.load() == (long)producers * items * (items + 1) / 2 && q->dequeue() == -2;
+    munmap(shared, sizeof(shmControl));
+    shmqueue::Detach(q);
+    if (name != NULL)
+    {
+        shmqueue::Unlink(name);
+    }
+    return passed;
+}
+/******************************************************************************
+ * Durable queue - same workload as the MS queue, every --batch operations
+ * the queue commits whatever it has.
+ *****************************************************************************/ 
+void * Durable_ThreadHandler(void * object)
+{
+    durablequeue * objectC = (durablequeue *)object;
+    for (int iterations = 0; iterations < numberLoops; ++iterations)
+    {
+        objectC->enqueue(iterations);
+#ifdef BACK_TO_BACK
+        objectC->dequeue();
+#endif 
+    }
+    while (objectC->dequeue() != -2)
+    {
+    }
+    return NULL;
+}
+
+/******************************************************************************
+ * @brief Run_Durable - Runs the durable workload on a log big enough to
+ *                      hold every element at once
+ * @param numberThreadsLocal - how many threads
+ *        report             - print the commit counts when true
+ * @return bool - true if the file could be opened and ended up empty
+ *****************************************************************************/
+static bool Run_Durable(int numberThreadsLocal, bool report)
+{
+    char scratch[64];
+    snprintf(scratch, sizeof(scratch), "containers_%d.dq", (int)getpid());
+    const char * path = (durablePath != NULL) ? durablePath : scratch;
+    durablequeue * q = durablequeue::Open(path, (size_t)numberThreadsLocal * numberLoops, batchSize);
+    if (q == NULL)
+    {
+        printf("Could not open %s\n", path);
+        return false;
+    }
+    pthread_t threads[numberThreadsLocal];
+    for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+    {
+        pthread_create(&threads[numThreads], NULL, Durable_ThreadHandler, q); 
+    }
+    for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+    {
+        pthread_join(threads[numThreads], NULL); 
+    }
+    if (report)
+    {
+        q->report();
+    }
+    bool empty = q->dequeue() == -2;
+    durablequeue::Close(q);
+    if (durablePath == NULL)
+    {
+        unlink(scratch);
+    }
+    return empty;
+}
+/******************************************************************************
+ * Thread-local cache - the Treiber workload through a tlcache in front of
+ * the shared stack. sum adds up val + 1 of every value popped, and the
+ * cache hands back whatever it still holds when the thread returns.
+ *****************************************************************************/ 
+template <class S>
+struct tlcacheStruct
+{
+    S * stack;
+    tlcache_stats stats;
+    atomic<long> sum;
+};
+
+template <class S>
+void * TLCache_ThreadHandler(void * object)
+{
+    tlcacheStruct<S> * objectC = (tlcacheStruct<S> *)object;
+    tlcache<S> cache(objectC->stack, tlcacheSize, tlcacheStaleness, &objectC->stats);
+    long sum = 0;
+#ifdef BACK_TO_BACK
+    for (int iterations = 0; iterations < numberLoops; ++iterations)
+    {
+        cache.push(iterations);
+        int val = cache.pop();
+        sum += (val != -2) ? val + 1 : 0;
+    }
+#else
+    for (int iterations = 0; iterations < numberLoops; ++iterations)
+    {
+        cache.push(iterations);
+    }
+    for (int iterations = 0; iterations < numberLoops; ++iterations)
+    {
+        int val = cache.pop();
+        sum += (val != -2) ? val + 1 : 0;
+    }
+#endif 
+    objectC->sum += sum;
+    return NULL;
+}
+
+/******************************************************************************
+ * @brief Run_TLCache - Runs the cached workload on stack, then empties it
+ * @param stack              - the shared stack, empty
+ *        numberThreadsLocal - how many threads
+ *        report             - print the hit rate when true
+ * @return bool - true if every value was popped exactly once, by a thread
+ *                or by the final drain
+ *****************************************************************************/
+template <class S>
+static bool Run_TLCache(S * stack, int numberThreadsLocal, bool report)
+{
+    pthread_t threads[numberThreadsLocal];
+    tlcacheStruct<S> threadPassIn;
+    threadPassIn.stack = stack;
+    threadPassIn.sum.store(0);
+    for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+    {
+        pthread_create(&threads[numThreads], NULL, TLCache_ThreadHandler<S>, &threadPassIn); 
+    }
+    for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+    {
+        pthread_join(threads[numThreads], NULL); 
+    }
+    if (report)
+    {
+        threadPassIn.stats.report();
+    }
+    long sum = threadPassIn.sum.load();
+    int val;
+    while ((val = stack->pop()) != -2)
+    {
+        sum += val + 1;
+    }
+    return sum == (long)numberThreadsLocal * numberLoops * (numberLoops + 1) / 2;
+}
+// Basic "Does it Run?" Tests
+/******************************************************************************
+ * @brief Test_PQ_Order - One thread, so delete_min must hand back every key
+ *                        in ascending order, across several prefix cuts
+ * @param none
+ * @return bool - true if it did
+ *****************************************************************************/ 
+static bool Test_PQ_Order(void)
+{
+    skiplistpq pq;
+    unsigned seed = 1;
+    int keys = 64 * PQ_BOUND_OFFSET;
+    for (int i = 0; i < keys; ++i)
+    {
+        pq.insert(Harness_Random(&seed) & PQ_KEY_MASK);
+    }
+    int last = -1;
+    for (int i = 0; i < keys; ++i)
+    {
+        int key = pq.delete_min();
+        if (key < last)
+        {
+            return false;
+        }
+        last = key;
+    }
+    return pq.delete_min() == -2;
+}
+static void * Thread_Ids_ThreadHandler(void * object)
+{
+    return (void *)(intptr_t)((threadids *)object)->mine();
+}
+/******************************************************************************
+ * @brief Test_Thread_Ids - One thread going back and forth between two
+ *                          objects must keep one id on each, and threads
+ *                          that come and go one after another must keep
+ *                          finding a free id on an object with room for two
+ * @param none
+ * @return bool - true if they did
+ *****************************************************************************/ 
+static bool Test_Thread_Ids(void)
+{
+    threadids a(2);
+    threadids b(2);
+    bool passed = true;
+    for (int i = 0; i < 300; ++i)
+    {
+        if (a.mine() != 0 || b.mine() != 0)
+        {
+            passed = false;
+        }
+    }
+    for (int i = 0; i < 300; ++i)
+    {
+        pthread_t thread;
+        void * id;
+        pthread_create(&thread, NULL, Thread_Ids_ThreadHandler, &a);
+        pthread_join(thread, &id);
+        if ((intptr_t)id != 1)
+        {
+            passed = false;
+        }
+    }
+    return passed && a.count() == 2 && b.count() == 1;
+}
+/******************************************************************************
+ * @brief Test_FC_Alternate - One thread going back and forth between a flat
+ *                            combining stack and queue must reuse its one
+ *                            record on each, and get LIFO and FIFO order
+ * @param none
+ * @return bool - true if it did
+ *****************************************************************************/ 
+static bool Test_FC_Alternate(void)
+{
+    fcstack fcStackObject;
+    fcqueue fcQueueObject;
+    bool passed = true;
+    for (int i = 0; i < 1000; ++i)
+    {
+        fcStackObject.push(i);
+        fcQueueObject.enqueue(i);
+    }
+    for (int i = 0; i < 1000; ++i)
+    {
+        if (fcStackObject.pop() != 999 - i || fcQueueObject.dequeue() != i)
+        {
+            passed = false;
+        }
+    }
+    return passed && fcStackObject.pop() == -2 && fcQueueObject.dequeue() == -2 &&
+           fcStackObject.enlisted() == 1 && fcQueueObject.enlisted() == 1;
+}
+/******************************************************************************
+ * @brief Test_Durable_Crash - Crash injection. A child process appends (and
+ *                             now and then takes) values numbered by
+ *                             position and round on a small log and is
+ *                             killed at a random moment. The parent
+ *                             reopens the file, and recovery must keep
+ *                             everything committed and hand back only
+ *                             values that match their positions and the
+ *                             round that last wrote there.
+ *
+ * SIGKILL loses nothing that reached the page cache, so by itself it only
+ * tests crashes at arbitrary points between stores. Lost writes are
+ * modelled on top of that: before reopening, the parent zeroes a random
+ * subset of the records the child was never told were durable, as if
+ * those pages never reached the disk. Torn or lost writes to the header,
+ * or losses inside what was acknowledged, are not modelled. That needs
+ * real power cuts or a block device that drops writes.
+ * @param none
+ * @return bool - true if every round recovered correctly
+ *****************************************************************************/ 
+static bool Test_Durable_Crash(void)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "containers_crash_%d.dq", (int)getpid());
+    unlink(path);
+    atomic<uint64_t> * acked = (atomic<uint64_t> *)mmap(NULL, 2 * sizeof(atomic<uint64_t>), PROT_READ | PROT_WRITE,
+                                                        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    new (&acked[0]) atomic<uint64_t>(0);    // Committed tail
+    new (&acked[1]) atomic<uint64_t>(0);    // Committed head
+    const size_t capacity = 64;
+    unsigned seed = 7;
+    // Lay the file out here, a child killed while creating it would leave
+    // one that Open rightly refuses
+    durablequeue * q0 = durablequeue::Open(path, capacity, 1);
+    bool passed = q0 != NULL;
+    if (q0 != NULL)
+    {
+        durablequeue::Close(q0);
+    }
+    // Values are position * 16 + the round that wrote them, and starts[r]
+    // is the tail round r began at, so a record revived from an earlier
+    // round shows up as the wrong writer
+    uint64_t starts[8];
+    fflush(stdout);
+    for (int round = 0; round < 8 && passed; ++round)
+    {
+        size_t batch = 1 + (round % 4) * 5;
+        starts[round] = acked[0].load();
+        pid_t child = fork();
+        if (child == 0)
+        {
+            durablequeue * q = durablequeue::Open(path, capacity, batch);
+            if (q == NULL)
+            {
+                _exit(1);
+            }
+            uint64_t h = q->durable_head();
+            for (uint64_t n = q->durable_tail(); ; ++n)
+            {
+                while (!q->enqueue((int)(n * 16 + round)))
+                {
+                    if ((q->dequeue() >> 4) != (int)h++)
+                    {
+                        _exit(2);
+                    }
+                }
+                if ((n % 3) == 0 && (q->dequeue() >> 4) != (int)h++)
+                {
+                    _exit(2);
+                }
+                // Tail before head, so the pair never claims more than fits
+                uint64_t tail = q->durable_tail();
+                acked[1].store(q->durable_head());
+                acked[0].store(tail);
+            }
+        }
+        usleep(Harness_Random(&seed) % 2000);
+        kill(child, SIGKILL);
+        int status;
+        waitpid(child, &status, 0);
+        if (!WIFSIGNALED(status))
+        {
+            passed = false;
+            break;
+        }
+        // Lose a random subset of the records the child was never told
+        // were durable. Slots past head + capacity still hold committed ones.
+        uint64_t tail = acked[0].load();
+        uint64_t head = acked[1].load();
+        int fd = open(path, O_RDWR);
+        uint64_t zero = 0;
+        for (uint64_t lost = tail; lost < head + capacity; ++lost)
+        {
+            if ((Harness_Random(&seed) & 1) &&
+                pwrite(fd, &zero, sizeof(zero), DQ_HEADER + (lost % capacity) * sizeof(uint64_t)) != sizeof(zero))
+            {
+                passed = false;
+            }
+        }
+        close(fd);
+        durablequeue * q = durablequeue::Open(path, capacity, batch);
+        if (q == NULL || q->durable_head() < head || q->durable_tail() < tail)
+        {
+            passed = false;
+            break;
+        }
+        // Take half of what came back, the next round starts from the rest
+        uint64_t h = q->durable_head();
+        size_t count = q->recovered();
+        for (size_t i = 0; i < count; ++i)
+        {
+            int val = q->dequeue();
+            int writer = round;
+            while (writer > 0 && starts[writer] > h + i)
+            {
+                --writer;
+            }
+            if (val != (int)((h + i) * 16 + writer))
+            {
+                passed = false;
+            }
+            if (i >= count / 2)
+            {
+                break;
+            }
+        }
+        q->commit();
+        acked[1].store(q->durable_head());
+        acked[0].store(q->durable_tail());
+        durablequeue::Close(q);
+    }
+    munmap(acked, 2 * sizeof(atomic<uint64_t>));
+    unlink(path);
+    return passed;
+}
+/******************************************************************************
+ * @brief Test_Treiber/Test_MS - Runs the plain workload on one policy
+ *                               instantiation
+ * @param numberThreadsLocal - how many threads
+ * @return none
+ *****************************************************************************/ 
+template <class S>
+static void Test_Treiber(int numberThreadsLocal)
+{
+    pthread_t threads[numberThreadsLocal];
+    S TreiberStack;
+    for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+    {
+        pthread_create(&threads[numThreads], NULL, Treiber_ThreadHandler<S>, &TreiberStack); 
+    }
+    for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+    {
+        pthread_join(threads[numThreads], NULL); 
+    } 
+}
+
+template <class Q>
+static void Test_MS(int numberThreadsLocal)
+{
+    pthread_t threads[numberThreadsLocal];
+    Q msqueueObject;
+    for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+    {
+        pthread_create(&threads[numThreads], NULL, MS_ThreadHandler<Q>, &msqueueObject); 
+    }
+    for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+    {
+        pthread_join(threads[numThreads], NULL); 
+    }
+}
+
+/******************************************************************************
+ * @brief Run_Queue - Runs Queue_ThreadHandler on one faa or wfq queue
+ * @param queue              - the queue
+ *        numberThreadsLocal - how many threads
+ * @return bool - true if as many elements came out as went in, adding up to
+ *                the same, and the queue was left empty
+ *****************************************************************************/ 
+template <class Q>
+static bool Run_Queue(Q * queue, int numberThreadsLocal)
+{
+    pthread_t threads[numberThreadsLocal];
+    queueTaken.store(0);
+    queueSum.store(0);
+    for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+    {
+        pthread_create(&threads[numThreads], NULL, Queue_ThreadHandler<Q>, queue); 
+    }
+    for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+    {
+        pthread_join(threads[numThreads], NULL); 
+    }
+    return queueTaken.load() == (long long)numberLoops * numberThreadsLocal &&
+           queueSum.load() == (long long)numberThreadsLocal * numberLoops * (numberLoops - 1) / 2 &&
+           queue->dequeue() == -2;
+}
+
+static bool test1(int * counter, int which, int numberThreadsLocal, int numIter)
+{
+    numberLoops = numIter;
+    pthread_t threads[numberThreadsLocal]; 
+    bool result = true;
+
+    switch(which)
+    {
+        case(SGL_S_e):
+        {
+            // SGL Stack
+            std::stack<int> lifoStack;
+            sglStackStruct stackStruct;
+            stackStruct.lifoStack = &lifoStack;
+
+            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            {
+                pthread_create(&threads[numThreads], NULL, SGL_Stack_ThreadHandler, &stackStruct); 
+            }
+            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            {
+                pthread_join(threads[numThreads], NULL); 
+            }
+            break;
+        }
+        case(SGL_Q_e):
+        {
+            // SGL Queue
+            std::queue<int> fifoQueue;
+            sglQueueStruct queueStruct;
+            queueStruct.fifoQueue = &fifoQueue;
+            queueStruct.loops = numberLoops;
+
+            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            {
+                pthread_create(&threads[numThreads], NULL, SGL_Queue_ThreadHandler, &queueStruct); 
+            }
+            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            {
+                pthread_join(threads[numThreads], NULL); 
+            } 
+            break;
+        }
+        case(TREIBER_e):
+        {
+            // Treiber Stack
+            tstack TreiberStack;
+            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            {
+                pthread_create(&threads[numThreads], NULL, Treiber_ThreadHandler<tstack>, &TreiberStack); 
+            }
+            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            {
+                pthread_join(threads[numThreads], NULL); 
+            } 
+            break;
+        }
+        case(TREIBER_BATCH_e):
+        case(MS_BATCH_e):
+        {
+            // Treiber Stack or MS queue, 8 element batches, every element
+            // has to come back out
+            tstack TreiberStack;
+            msqueue msqueueObject;
+            int batchSaved = batchSize;
+            batchSize = 8;
+            batchTaken.store(0);
+            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            {
+                if (which == TREIBER_BATCH_e)
+                {
+                    pthread_create(&threads[numThreads], NULL, Treiber_Batch_ThreadHandler<tstack>, &TreiberStack); 
+                }
+                else
+                {
+                    pthread_create(&threads[numThreads], NULL, MS_Batch_ThreadHandler<msqueue>, &msqueueObject); 
+                }
+            }
+            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            {
+                pthread_join(threads[numThreads], NULL); 
+            }
+            batchSize = batchSaved;
+            if (batchTaken.load() != (long long)numberLoops * numberThreadsLocal ||
+                TreiberStack.pop() != -2 || msqueueObject.dequeue() != -2)
+            {
+                result = false;
+            }
+            break;
+        }
+        case(TREIBER_DRAIN_e):
+        case(MS_DRAIN_e):
+        {
+            // Treiber Stack or MS queue, drained with pop_all/dequeue_all,
+            // which between them must take every element exactly once
+            tstack TreiberStack;
+            msqueue msqueueObject;
+            bool drainSaved = drainAll;
+            drainAll = true;
+            vector<int> vals;
+            drained = &vals;
+            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            {
+                if (which == TREIBER_DRAIN_e)
+                {
+                    pthread_create(&threads[numThreads], NULL, Treiber_ThreadHandler<tstack>, &TreiberStack); 
+                }
+                else
+                {
+                    pthread_create(&threads[numThreads], NULL, MS_ThreadHandler<msqueue>, &msqueueObject); 
+                }
+            }
+            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            {
+                pthread_join(threads[numThreads], NULL); 
+            }
+            drainAll = drainSaved;
+            drained = NULL;
+            // Every thread pushed 0 .. numberLoops - 1
+            vector<int> seen(numberLoops, 0);
+            for (size_t i = 0; i < vals.size(); ++i)
+            {
+                if (vals[i] < 0 || vals[i] >= numberLoops || ++seen[vals[i]] > numberThreadsLocal)
+                {
+                    result = false;
+                }
+            }
+            if (vals.size() != (size_t)numberLoops * numberThreadsLocal ||
+                TreiberStack.pop() != -2 || msqueueObject.dequeue() != -2)
+            {
+                result = false;
+            }
+            break;
+        }
+        case(TREIBER_POLICY_e):
+        {
+            // Treiber Stack, the instantiations other than tstack
+            Test_Treiber< basic_tstack<seqcst_policy> >(numberThreadsLocal);
+            Test_Treiber< basic_tstack<seqcst_padded_policy> >(numberThreadsLocal);
+            Test_Treiber< basic_tstack<acqrel_padded_policy> >(numberThreadsLocal);
+            break;
+        }
+        case(MS_POLICY_e):
+        {
+            // MS queue, the instantiations other than msqueue
+            Test_MS< basic_msqueue<acqrel_policy> >(numberThreadsLocal);
+            Test_MS< basic_msqueue<seqcst_padded_policy> >(numberThreadsLocal);
+            Test_MS< basic_msqueue<acqrel_padded_policy> >(numberThreadsLocal);
+            break;
+        }
+        case(MS_e):
+        {
+            // MS queue
+            msqueue msqueueObject;  // Create the Object
+            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            {
+                pthread_create(&threads[numThreads], NULL, MS_ThreadHandler<msqueue>, &msqueueObject); 
+            }
+            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            {
+                pthread_join(threads[numThreads], NULL); 
+            }
+            break;
+        }
+        case(FAA_e):
+        {
+            // Fetch-and-Add Array Queue, largest and smallest segments
+            for (int segment = FAA_NODE_SIZE; segment >= FAA_MIN_NODE; segment /= 16)
+            {
+                faaqueue faaObject(segment);
+                if (!Run_Queue(&faaObject, numberThreadsLocal))
+                {
+                    result = false;
+                }
+            }
+            break;
+        }
+        case(WFQ_e):
+        {
+            // Wait-Free Queue, then every operation down the slow path under
+            // each reclamation scheme, as the fast path hardly ever fails
+            wfqueue * wfqObject = new wfqueue;
+            bool passed = Run_Queue(wfqObject, numberThreadsLocal);
+            delete wfqObject;
+            reclaim_t schemeSaved = reclaimScheme;
+            const reclaim_t schemes[3] = {RECLAIM_HP_e, RECLAIM_EBR_e, RECLAIM_NONE_e};
+            for (int scheme = 0; scheme < 3; ++scheme)
+            {
+                reclaimScheme = schemes[scheme];
+                wfqObject = new wfqueue(0);
+                passed = Run_Queue(wfqObject, numberThreadsLocal) && passed;
+                delete wfqObject;
+                Reclaim_Flush();
+            }
+            reclaimScheme = schemeSaved;
+            if (!passed)
+            {
+                result = false;
+            }
+            break;
+        }
+        case(MQ_e):
+        {
+            // Relaxed FIFO MultiQueue, every element has to come back out
+            multiqueue mqObject(MQ_SHARDS_PER_THREAD * numberThreadsLocal);
+            vector<mq_stamps> stamps;
+            mqStruct threadPassIn;
+            threadPassIn.mq = &mqObject;
+            threadPassIn.stamps = &stamps;
+            pthread_mutex_init(&threadPassIn.lock, NULL);
+            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            {
+                pthread_create(&threads[numThreads], NULL, MQ_ThreadHandler, &threadPassIn); 
+            }
+            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            {
+                pthread_join(threads[numThreads], NULL); 
+            }
+            pthread_mutex_destroy(&threadPassIn.lock);
+            double mean;
+            unsigned long long max;
+            MQ_RankError(stamps, &mean, &max);
+            if (stamps.size() != (size_t)numberLoops * numberThreadsLocal)
+            {
+                result = false;
+            }
+            break;
+        }
+        case(WSDEQUE_e):
+        {
+            // Work-Stealing Deques, small enough that they grow
+            if (!Run_Steal(numberThreadsLocal, 2, false))
+            {
+                result = false;
+            }
+            break;
+        }
+        case(PQ_e):
+        {
+            // Skiplist Priority Queue
+            skiplistpq pqObject;
+            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            {
+                pthread_create(&threads[numThreads], NULL, PQ_ThreadHandler, &pqObject); 
+            }
+            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            {
+                pthread_join(threads[numThreads], NULL); 
+            }
+            if (!Test_PQ_Order())
+            {
+                result = false;
+            }
+            break;
+        }
+        case(SGL_PQ_e):
+        {
+            // SGL Priority Queue
+            minQueue minPQ;
+            sglPQStruct pqStruct;
+            pqStruct.minPQ = &minPQ;
+            pqStruct.loops = numberLoops;
+            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            {
+                pthread_create(&threads[numThreads], NULL, SGL_PQ_ThreadHandler, &pqStruct); 
+            }
+            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            {
+                pthread_join(threads[numThreads], NULL); 
+            }
+            break;
+        }
+        case(MS_WAIT_e):
+        {
+            // MS queue, one producer and parked consumers, then a wait that times out
+            if (!Run_Waiters(MS_WAIT_e, 1, (numberThreadsLocal < 2) ? 1 : numberThreadsLocal - 1, false))
+            {
+                result = false;
+            }
+            msqueue msqueueObject;
+            if (msqueueObject.dequeue_wait(&waitTimeout) != -2)
+            {
+                result = false;
+            }
+            break;
+        }
+        case(BASKET_WAIT_e):
+        {
+            // Basket queue, one producer and parked consumers
+            if (!Run_Waiters(BASKET_WAIT_e, 1, (numberThreadsLocal < 2) ? 1 : numberThreadsLocal - 1, false))
+            {
+                result = false;
+            }
+            break;
+        }
+        case(BOUNDED_e):
+        {
+            // Bounded Blocking Queue, small enough that producers park, in
+            // batches too
+            size_t capacitySaved = ringCapacity;
+            int batchSaved = batchSize;
+            ringCapacity = 4;
+            bool passed = Run_Waiters(BOUNDED_e, numberThreadsLocal, 1, false);
+            batchSize = 3;
+            passed = passed && Run_Waiters(BOUNDED_e, numberThreadsLocal, 1, false);
+            ringCapacity = capacitySaved;
+            batchSize = batchSaved;
+            boundedqueue boundedObject(2);
+            int vals[3] = {1, 2, 3};
+            if (!passed ||
+                boundedObject.try_enqueue_batch(vals, 3) != 2 ||
+                boundedObject.try_enqueue(4) ||
+                boundedObject.dequeue() != 1 ||
+                !boundedObject.try_enqueue(4))
+            {
+                result = false;
+            }
+            break;
+        }
+        case(ITREIBER_e):
+        case(IMS_e):
+        {
+            // Intrusive Treiber Stack or MS queue, smallest and largest
+            // payloads, each against its wrapped run
+            int payloadSaved = payloadSize;
+            bool wrappedSaved = wrappedPayload;
+            bool passed = true;
+            for (int run = 0; run < 4; ++run)
+            {
+                payloadSize = (run & 1) ? 256 : 64;
+                wrappedPayload = (run & 2) != 0;
+                passed = Run_Intrusive(which == IMS_e, numberThreadsLocal) && passed;
+            }
+            payloadSize = payloadSaved;
+            wrappedPayload = wrappedSaved;
+            if (!passed)
+            {
+                result = false;
+            }
+            break;
+        }
+        case(TLCACHE_e):
+        {
+            // Thread-local cache in front of the Treiber and elimination
+            // backoff stacks, then one slot spilled on every operation
+            size_t sizeSaved = tlcacheSize;
+            size_t stalenessSaved = tlcacheStaleness;
+            tstack TreiberStack;
+            elimstack elimObject(numberThreadsLocal / 2);
+            tlcacheSize = 16;
+            tlcacheStaleness = 8;
+            bool passed = Run_TLCache(&TreiberStack, numberThreadsLocal, false);
+            passed = Run_TLCache(&elimObject, numberThreadsLocal, false) && passed;
+            tlcacheSize = 1;
+            tlcacheStaleness = 0;
+            passed = Run_TLCache(&TreiberStack, numberThreadsLocal, false) && passed;
+            tlcacheSize = sizeSaved;
+            tlcacheStaleness = stalenessSaved;
+            if (!passed)
+            {
+                result = false;
+            }
+            break;
+        }
+        case(DURABLE_e):
+        {
+            // Durable queue, group commits, then crash recovery
+            int batchSaved = batchSize;
+            batchSize = 64;
+            bool passed = Run_Durable(numberThreadsLocal, false);
+            batchSize = batchSaved;
+            if (!passed || !Test_Durable_Crash())
+            {
+                result = false;
+            }
+            break;
+        }
+        case(SHM_e):
+        {
+            // Inter-process queue, inherited and then attached by name,
+            // with a small region so producers run into it being full
+            char name[32];
+            snprintf(name, sizeof(name), "/containers_shm_%d", (int)getpid());
+            int producers = (numberThreadsLocal < 2) ? 1 : numberThreadsLocal / 2;
+            int consumers = (numberThreadsLocal - producers < 1) ? 1 : numberThreadsLocal - producers;
+            size_t capacitySaved = ringCapacity;
+            ringCapacity = 16;
+            bool passed = Run_Processes(producers, consumers, NULL, false);
+            passed = Run_Processes(producers, consumers, name, false) && passed;
+            ringCapacity = capacitySaved;
+            if (!passed)
+            {
+                result = false;
+            }
+            break;
+        }
+        case(TYPED_TREIBER_e):
+        case(TYPED_MS_e):
+        case(TYPED_SGL_S_e):
+        case(TYPED_SGL_Q_e):
+        {
+            // Typed containers, smallest and largest messages
+            int payloadSaved = payloadSize;
+            payloadSize = 4;
+            bool passed = Run_Typed(which, numberThreadsLocal);
+            payloadSize = 512;
+            passed = Run_Typed(which, numberThreadsLocal) && passed;
+            payloadSize = payloadSaved;
+            if (!passed)
+            {
+                result = false;
+            }
+            break;
+        }
+        case(BASKET_e):
+        {
+            // Basket queue
+            queue_t * queueInput = new queue_t;
+            init_queue(queueInput);
+            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            {
+                pthread_create(&threads[numThreads], NULL, Basket_ThreadHandler, queueInput); 
+            }
+            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            {
+                pthread_join(threads[numThreads], NULL); 
+            }
+            destroy_queue(queueInput);
+            delete queueInput;
+            break;
+        }
+        case(ESGL_e):
+        {
+            // Elimination SGL Stack
+            std::stack<int> lifoStack;
+            sglStackStruct stackStruct;
+            stackStruct.lifoStack = &lifoStack;
+            estack estackObject;  // Create the Object
+            elimSGL threadPassIn;
+            threadPassIn.sgl = &stackStruct;
+            threadPassIn.elim = &estackObject;
+
+            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            {
+                pthread_create(&threads[numThreads], NULL, E_SGL_Stack_ThreadHandler, &threadPassIn); 
+            }
+            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            {
+                pthread_join(threads[numThreads], NULL); 
+            }
+            break;
+        }
+        case(ET_e):
+        {
+            // Elimination Treiber Stack
+            tstack TreiberStack;
+            estack estackObject;  // Create the Object
+            elimTreiber threadPassIn;
+            threadPassIn.treiber = &TreiberStack;
+            threadPassIn.elim = &estackObject;
+
+            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            {
+                pthread_create(&threads[numThreads], NULL, E_Treiber_Stack_ThreadHandler, &threadPassIn); 
+            }
+            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            {
+                pthread_join(threads[numThreads], NULL); 
+            }
+            break;
+        }
+        case(ELIM_e):
+        {
+            // Elimination Backoff Stack
+            elimstack elimObject(numberThreadsLocal / 2);
+            elimEmpty.store(0);
+            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            {
+                pthread_create(&threads[numThreads], NULL, Elim_ThreadHandler, &elimObject); 
+            }
+            for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
+            {
+                pthread_join(threads[numThreads], NULL); 
+            }
+            if (elimEmpty.load() != 0 || elimObject.pop() != -2 || !Test_Thread_Ids())
+            {
+                result = false;
+            }
+            break;
+        }
+        case(FC_S_e):
+        {
+            // Flat Combining Stack
+            fcstack fcStackObject;
             for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
             {
-                pthread_create(&threads[numThreads], NULL, Basket_ThreadHandler, queueInput); 
+                pthread_create(&threads[numThreads], NULL, FC_Stack_ThreadHandler, &fcStackObject); 
             }
             for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
             {
                 pthread_join(threads[numThreads], NULL); 
             }
-            delete queueInput;
+            if (!Test_FC_Alternate())
+            {
+                result = false;
+            }
             break;
         }
-        case(ESGL_e):
+        case(RING_e):
         {
-            // Elimination SGL Stack
-            std::stack<int> lifoStack;
-            sglStackStruct stackStruct;
-            stackStruct.lifoStack = &lifoStack;
-            estack estackObject;  // Create the Object
-            elimSGL threadPassIn;
-            threadPassIn.sgl = &stackStruct;
-            threadPassIn.elim = &estackObject;
-
+            // Bounded MPMC Ring Queue, small enough that it fills up, every
+            // element has to come back out once
+            ringqueue ringObject(1024);
+            ringTaken.store(0);
+            ringSum.store(0);
             for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
             {
-                pthread_create(&threads[numThreads], NULL, E_SGL_Stack_ThreadHandler, &threadPassIn); 
+                pthread_create(&threads[numThreads], NULL, Ring_ThreadHandler, &ringObject); 
             }
             for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
             {
                 pthread_join(threads[numThreads], NULL); 
             }
+            int val;
+            if (ringTaken.load() != (long long)numberLoops * numberThreadsLocal ||
+                ringSum.load() != (long long)numberThreadsLocal * numberLoops * (numberLoops - 1) / 2 ||
+                ringObject.try_dequeue(val))
+            {
+                result = false;
+            }
             break;
         }
-        case(ET_e):
+        case(SPSC_e):
         {
-            // Elimination Treiber Stack
-            tstack TreiberStack;
-            estack estackObject;  // Create the Object
-            elimTreiber threadPassIn;
-            threadPassIn.treiber = &TreiberStack;
-            threadPassIn.elim = &estackObject;
-
+            // SPSC Rings, one per producer/consumer pair
+            if (!Run_Pairs(true, (numberThreadsLocal < 2) ? 1 : numberThreadsLocal / 2))
+            {
+                result = false;
+            }
+            break;
+        }
+        case(FC_Q_e):
+        {
+            // Flat Combining Queue
+            fcqueue fcQueueObject;
             for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
             {
-                pthread_create(&threads[numThreads], NULL, E_Treiber_Stack_ThreadHandler, &threadPassIn); 
+                pthread_create(&threads[numThreads], NULL, FC_Queue_ThreadHandler, &fcQueueObject); 
             }
             for (int numThreads = 0; numThreads < numberThreadsLocal; ++numThreads)
             {
@@ -435,6 +2670,12 @@ static bool test1(int * counter, int which, int numberThreadsLocal, int numIter)
             break;
         }
     }
+    Reclaim_Flush();
+    if (!result)
+    {
+        printf("Test %d failed with %d threads and %d loops\n", which, numberThreadsLocal, numIter);
+        return false;
+    }
     ++(*counter);
     return true;
 }
@@ -442,103 +2683,652 @@ static bool test1(int * counter, int which, int numberThreadsLocal, int numIter)
 static bool testSuite(int * counter)
 {
     test ff;
+    bool passed = true;
 /******************************************************************************
 * 100 LEVEL TESTS
 ******************************************************************************/
     // 1 thread 5 elements
         ff = SGL_Q_e;
-    test1(counter, ff, 1, 5);
+    passed = test1(counter, ff, 1, 5) && passed;
         ff = SGL_S_e;
-    test1(counter, ff, 1, 5);
+    passed = test1(counter, ff, 1, 5) && passed;
         ff = ET_e;
-    test1(counter, ff, 1, 5);
+    passed = test1(counter, ff, 1, 5) && passed;
         ff = TREIBER_e;
-    test1(counter, ff, 1, 5);
+    passed = test1(counter, ff, 1, 5) && passed;
+        ff = TREIBER_BATCH_e;
+    passed = test1(counter, ff, 1, 5) && passed;
+        ff = TREIBER_DRAIN_e;
+    passed = test1(counter, ff, 1, 5) && passed;
+        ff = TREIBER_POLICY_e;
+    passed = test1(counter, ff, 1, 5) && passed;
         ff = ESGL_e;
-    test1(counter, ff, 1, 5);
+    passed = test1(counter, ff, 1, 5) && passed;
         ff = BASKET_e;
-    test1(counter, ff, 1, 5);
+    passed = test1(counter, ff, 1, 5) && passed;
+        ff = BASKET_WAIT_e;
+    passed = test1(counter, ff, 1, 5) && passed;
         ff = MS_e;
-    test1(counter, ff, 1, 5);
+    passed = test1(counter, ff, 1, 5) && passed;
+        ff = MS_BATCH_e;
+    passed = test1(counter, ff, 1, 5) && passed;
+        ff = MS_DRAIN_e;
+    passed = test1(counter, ff, 1, 5) && passed;
+        ff = MS_WAIT_e;
+    passed = test1(counter, ff, 1, 5) && passed;
+        ff = MS_POLICY_e;
+    passed = test1(counter, ff, 1, 5) && passed;
+        ff = FAA_e;
+    passed = test1(counter, ff, 1, 5) && passed;
+        ff = WFQ_e;
+    passed = test1(counter, ff, 1, 5) && passed;
+        ff = MQ_e;
+    passed = test1(counter, ff, 1, 5) && passed;
+        ff = WSDEQUE_e;
+    passed = test1(counter, ff, 1, 5) && passed;
+        ff = PQ_e;
+    passed = test1(counter, ff, 1, 5) && passed;
+        ff = SGL_PQ_e;
+    passed = test1(counter, ff, 1, 5) && passed;
+        ff = BOUNDED_e;
+    passed = test1(counter, ff, 1, 5) && passed;
+        ff = ITREIBER_e;
+    passed = test1(counter, ff, 1, 5) && passed;
+        ff = IMS_e;
+    passed = test1(counter, ff, 1, 5) && passed;
+        ff = TYPED_TREIBER_e;
+    passed = test1(counter, ff, 1, 5) && passed;
+        ff = TYPED_MS_e;
+    passed = test1(counter, ff, 1, 5) && passed;
+        ff = TYPED_SGL_S_e;
+    passed = test1(counter, ff, 1, 5) && passed;
+        ff = TYPED_SGL_Q_e;
+    passed = test1(counter, ff, 1, 5) && passed;
+        ff = SHM_e;
+    passed = test1(counter, ff, 1, 5) && passed;
+        ff = DURABLE_e;
+    passed = test1(counter, ff, 1, 5) && passed;
+        ff = TLCACHE_e;
+    passed = test1(counter, ff, 1, 5) && passed;
+        ff = ELIM_e;
+    passed = test1(counter, ff, 1, 5) && passed;
+        ff = FC_S_e;
+    passed = test1(counter, ff, 1, 5) && passed;
+        ff = FC_Q_e;
+    passed = test1(counter, ff, 1, 5) && passed;
+        ff = RING_e;
+    passed = test1(counter, ff, 1, 5) && passed;
+        ff = SPSC_e;
+    passed = test1(counter, ff, 1, 5) && passed;
     // 2 threads 5 elements
         ff = SGL_Q_e;
-    test1(counter, ff, 2, 5);
+    passed = test1(counter, ff, 2, 5) && passed;
         ff = SGL_S_e;
-    test1(counter, ff, 2, 5);
+    passed = test1(counter, ff, 2, 5) && passed;
         ff = ET_e;
-    test1(counter, ff, 2, 5);
+    passed = test1(counter, ff, 2, 5) && passed;
         ff = TREIBER_e;
-    test1(counter, ff, 2, 5);
+    passed = test1(counter, ff, 2, 5) && passed;
+        ff = TREIBER_BATCH_e;
+    passed = test1(counter, ff, 2, 5) && passed;
+        ff = TREIBER_DRAIN_e;
+    passed = test1(counter, ff, 2, 5) && passed;
+        ff = TREIBER_POLICY_e;
+    passed = test1(counter, ff, 2, 5) && passed;
         ff = ESGL_e;
-    test1(counter, ff, 2, 5);
+    passed = test1(counter, ff, 2, 5) && passed;
         ff = BASKET_e;
-    test1(counter, ff, 2, 5);
+    passed = test1(counter, ff, 2, 5) && passed;
+        ff = BASKET_WAIT_e;
+    passed = test1(counter, ff, 2, 5) && passed;
         ff = MS_e;
-    test1(counter, ff, 2, 5);
+    passed = test1(counter, ff, 2, 5) && passed;
+        ff = MS_BATCH_e;
+    passed = test1(counter, ff, 2, 5) && passed;
+        ff = MS_DRAIN_e;
+    passed = test1(counter, ff, 2, 5) && passed;
+        ff = MS_WAIT_e;
+    passed = test1(counter, ff, 2, 5) && passed;
+        ff = MS_POLICY_e;
+    passed = test1(counter, ff, 2, 5) && passed;
+        ff = FAA_e;
+    passed = test1(counter, ff, 2, 5) && passed;
+        ff = WFQ_e;
+    passed = test1(counter, ff, 2, 5) && passed;
+        ff = MQ_e;
+    passed = test1(counter, ff, 2, 5) && passed;
+        ff = WSDEQUE_e;
+    passed = test1(counter, ff, 2, 5) && passed;
+        ff = PQ_e;
+    passed = test1(counter, ff, 2, 5) && passed;
+        ff = SGL_PQ_e;
+    passed = test1(counter, ff, 2, 5) && passed;
+        ff = BOUNDED_e;
+    passed = test1(counter, ff, 2, 5) && passed;
+        ff = ITREIBER_e;
+    passed = test1(counter, ff, 2, 5) && passed;
+        ff = IMS_e;
+    passed = test1(counter, ff, 2, 5) && passed;
+        ff = TYPED_TREIBER_e;
+    passed = test1(counter, ff, 2, 5) && passed;
+        ff = TYPED_MS_e;
+    passed = test1(counter, ff, 2, 5) && passed;
+        ff = TYPED_SGL_S_e;
+    passed = test1(counter, ff, 2, 5) && passed;
+        ff = TYPED_SGL_Q_e;
+    passed = test1(counter, ff, 2, 5) && passed;
+        ff = SHM_e;
+    passed = test1(counter, ff, 2, 5) && passed;
+        ff = DURABLE_e;
+    passed = test1(counter, ff, 2, 5) && passed;
+        ff = TLCACHE_e;
+    passed = test1(counter, ff, 2, 5) && passed;
+        ff = ELIM_e;
+    passed = test1(counter, ff, 2, 5) && passed;
+        ff = FC_S_e;
+    passed = test1(counter, ff, 2, 5) && passed;
+        ff = FC_Q_e;
+    passed = test1(counter, ff, 2, 5) && passed;
+        ff = RING_e;
+    passed = test1(counter, ff, 2, 5) && passed;
+        ff = SPSC_e;
+    passed = test1(counter, ff, 2, 5) && passed;
     // 16 threads
         ff = ET_e;
-    test1(counter, ff, 16, 5);
+    passed = test1(counter, ff, 16, 5) && passed;
         ff = SGL_Q_e;
-    test1(counter, ff, 16, 5);
+    passed = test1(counter, ff, 16, 5) && passed;
         ff = SGL_S_e;
-    test1(counter, ff, 16, 5);
+    passed = test1(counter, ff, 16, 5) && passed;
         ff = TREIBER_e;
-    test1(counter, ff, 16, 5);
+    passed = test1(counter, ff, 16, 5) && passed;
+        ff = TREIBER_BATCH_e;
+    passed = test1(counter, ff, 16, 5) && passed;
+        ff = TREIBER_DRAIN_e;
+    passed = test1(counter, ff, 16, 5) && passed;
+        ff = TREIBER_POLICY_e;
+    passed = test1(counter, ff, 16, 5) && passed;
         ff = ESGL_e;
-    test1(counter, ff, 16, 5);
+    passed = test1(counter, ff, 16, 5) && passed;
         ff = BASKET_e;
-    test1(counter, ff, 16, 5);
+    passed = test1(counter, ff, 16, 5) && passed;
+        ff = BASKET_WAIT_e;
+    passed = test1(counter, ff, 16, 5) && passed;
         ff = MS_e;
-    test1(counter, ff, 16, 5);
+    passed = test1(counter, ff, 16, 5) && passed;
+        ff = MS_BATCH_e;
+    passed = test1(counter, ff, 16, 5) && passed;
+        ff = MS_DRAIN_e;
+    passed = test1(counter, ff, 16, 5) && passed;
+        ff = MS_WAIT_e;
+    passed = test1(counter, ff, 16, 5) && passed;
+        ff = MS_POLICY_e;
+    passed = test1(counter, ff, 16, 5) && passed;
+        ff = FAA_e;
+    passed = test1(counter, ff, 16, 5) && passed;
+        ff = WFQ_e;
+    passed = test1(counter, ff, 16, 5) && passed;
+        ff = MQ_e;
+    passed = test1(counter, ff, 16, 5) && passed;
+        ff = WSDEQUE_e;
+    passed = test1(counter, ff, 16, 5) && passed;
+        ff = PQ_e;
+    passed = test1(counter, ff, 16, 5) && passed;
+        ff = SGL_PQ_e;
+    passed = test1(counter, ff, 16, 5) && passed;
+        ff = BOUNDED_e;
+    passed = test1(counter, ff, 16, 5) && passed;
+        ff = ITREIBER_e;
+    passed = test1(counter, ff, 16, 5) && passed;
+        ff = IMS_e;
+    passed = test1(counter, ff, 16, 5) && passed;
+        ff = TYPED_TREIBER_e;
+    passed = test1(counter, ff, 16, 5) && passed;
+        ff = TYPED_MS_e;
+    passed = test1(counter, ff, 16, 5) && passed;
+        ff = TYPED_SGL_S_e;
+    passed = test1(counter, ff, 16, 5) && passed;
+        ff = TYPED_SGL_Q_e;
+    passed = test1(counter, ff, 16, 5) && passed;
+        ff = SHM_e;
+    passed = test1(counter, ff, 16, 5) && passed;
+        ff = DURABLE_e;
+    passed = test1(counter, ff, 16, 5) && passed;
+        ff = TLCACHE_e;
+    passed = test1(counter, ff, 16, 5) && passed;
+        ff = ELIM_e;
+    passed = test1(counter, ff, 16, 5) && passed;
+        ff = FC_S_e;
+    passed = test1(counter, ff, 16, 5) && passed;
+        ff = FC_Q_e;
+    passed = test1(counter, ff, 16, 5) && passed;
+        ff = RING_e;
+    passed = test1(counter, ff, 16, 5) && passed;
+        ff = SPSC_e;
+    passed = test1(counter, ff, 16, 5) && passed;
 /******************************************************************************
 * 200 LEVEL TESTS
 ******************************************************************************/
     // Testing 1 thread, 200000 elements
         ff = ET_e;
-    test1(counter, ff, 1, 200000);
+    passed = test1(counter, ff, 1, 200000) && passed;
         ff = SGL_Q_e;
-    test1(counter, ff, 1, 200000);
+    passed = test1(counter, ff, 1, 200000) && passed;
         ff = SGL_S_e;
-    test1(counter, ff, 1, 200000);
+    passed = test1(counter, ff, 1, 200000) && passed;
         ff = TREIBER_e;
-    test1(counter, ff, 1, 200000);
+    passed = test1(counter, ff, 1, 200000) && passed;
+        ff = TREIBER_BATCH_e;
+    passed = test1(counter, ff, 1, 200000) && passed;
+        ff = TREIBER_DRAIN_e;
+    passed = test1(counter, ff, 1, 200000) && passed;
+        ff = TREIBER_POLICY_e;
+    passed = test1(counter, ff, 1, 200000) && passed;
         ff = ESGL_e;
-    test1(counter, ff, 1, 200000);
+    passed = test1(counter, ff, 1, 200000) && passed;
         ff = BASKET_e;
-    test1(counter, ff, 1, 200000);
+    passed = test1(counter, ff, 1, 200000) && passed;
+        ff = BASKET_WAIT_e;
+    passed = test1(counter, ff, 1, 200000) && passed;
         ff = MS_e;
-    test1(counter, ff, 1, 200000);
+    passed = test1(counter, ff, 1, 200000) && passed;
+        ff = MS_BATCH_e;
+    passed = test1(counter, ff, 1, 200000) && passed;
+        ff = MS_DRAIN_e;
+    passed = test1(counter, ff, 1, 200000) && passed;
+        ff = MS_WAIT_e;
+    passed = test1(counter, ff, 1, 200000) && passed;
+        ff = MS_POLICY_e;
+    passed = test1(counter, ff, 1, 200000) && passed;
+        ff = FAA_e;
+    passed = test1(counter, ff, 1, 200000) && passed;
+        ff = WFQ_e;
+    passed = test1(counter, ff, 1, 200000) && passed;
+        ff = MQ_e;
+    passed = test1(counter, ff, 1, 200000) && passed;
+        ff = WSDEQUE_e;
+    passed = test1(counter, ff, 1, 200000) && passed;
+        ff = PQ_e;
+    passed = test1(counter, ff, 1, 200000) && passed;
+        ff = SGL_PQ_e;
+    passed = test1(counter, ff, 1, 200000) && passed;
+        ff = BOUNDED_e;
+    passed = test1(counter, ff, 1, 200000) && passed;
+        ff = ITREIBER_e;
+    passed = test1(counter, ff, 1, 200000) && passed;
+        ff = IMS_e;
+    passed = test1(counter, ff, 1, 200000) && passed;
+        ff = TYPED_TREIBER_e;
+    passed = test1(counter, ff, 1, 200000) && passed;
+        ff = TYPED_MS_e;
+    passed = test1(counter, ff, 1, 200000) && passed;
+        ff = TYPED_SGL_S_e;
+    passed = test1(counter, ff, 1, 200000) && passed;
+        ff = TYPED_SGL_Q_e;
+    passed = test1(counter, ff, 1, 200000) && passed;
+        ff = SHM_e;
+    passed = test1(counter, ff, 1, 200000) && passed;
+        ff = DURABLE_e;
+    passed = test1(counter, ff, 1, 200000) && passed;
+        ff = TLCACHE_e;
+    passed = test1(counter, ff, 1, 200000) && passed;
+        ff = ELIM_e;
+    passed = test1(counter, ff, 1, 200000) && passed;
+        ff = FC_S_e;
+    passed = test1(counter, ff, 1, 200000) && passed;
+        ff = FC_Q_e;
+    passed = test1(counter, ff, 1, 200000) && passed;
+        ff = RING_e;
+    passed = test1(counter, ff, 1, 200000) && passed;
+        ff = SPSC_e;
+    passed = test1(counter, ff, 1, 200000) && passed;
     // 2 threads
         ff = SGL_Q_e;
-    test1(counter, ff, 2, 200000);
+    passed = test1(counter, ff, 2, 200000) && passed;
         ff = SGL_S_e;
-    test1(counter, ff, 2, 200000);
+    passed = test1(counter, ff, 2, 200000) && passed;
         ff = TREIBER_e;
-    test1(counter, ff, 2, 200000);
+    passed = test1(counter, ff, 2, 200000) && passed;
+        ff = TREIBER_BATCH_e;
+    passed = test1(counter, ff, 2, 200000) && passed;
+        ff = TREIBER_DRAIN_e;
+    passed = test1(counter, ff, 2, 200000) && passed;
+        ff = TREIBER_POLICY_e;
+    passed = test1(counter, ff, 2, 200000) && passed;
         ff = ESGL_e;
-    test1(counter, ff, 2, 200000);
+    passed = test1(counter, ff, 2, 200000) && passed;
         ff = BASKET_e;
-    test1(counter, ff, 2, 200000);
+    passed = test1(counter, ff, 2, 200000) && passed;
+        ff = BASKET_WAIT_e;
+    passed = test1(counter, ff, 2, 200000) && passed;
         ff = MS_e;
-    test1(counter, ff, 2, 200000);
+    passed = test1(counter, ff, 2, 200000) && passed;
+        ff = MS_BATCH_e;
+    passed = test1(counter, ff, 2, 200000) && passed;
+        ff = MS_DRAIN_e;
+    passed = test1(counter, ff, 2, 200000) && passed;
+        ff = MS_WAIT_e;
+    passed = test1(counter, ff, 2, 200000) && passed;
+        ff = MS_POLICY_e;
+    passed = test1(counter, ff, 2, 200000) && passed;
+        ff = FAA_e;
+    passed = test1(counter, ff, 2, 200000) && passed;
+        ff = WFQ_e;
+    passed = test1(counter, ff, 2, 200000) && passed;
+        ff = MQ_e;
+    passed = test1(counter, ff, 2, 200000) && passed;
+        ff = WSDEQUE_e;
+    passed = test1(counter, ff, 2, 200000) && passed;
+        ff = PQ_e;
+    passed = test1(counter, ff, 2, 200000) && passed;
+        ff = SGL_PQ_e;
+    passed = test1(counter, ff, 2, 200000) && passed;
+        ff = BOUNDED_e;
+    passed = test1(counter, ff, 2, 200000) && passed;
+        ff = ITREIBER_e;
+    passed = test1(counter, ff, 2, 200000) && passed;
+        ff = IMS_e;
+    passed = test1(counter, ff, 2, 200000) && passed;
+        ff = TYPED_TREIBER_e;
+    passed = test1(counter, ff, 2, 200000) && passed;
+        ff = TYPED_MS_e;
+    passed = test1(counter, ff, 2, 200000) && passed;
+        ff = TYPED_SGL_S_e;
+    passed = test1(counter, ff, 2, 200000) && passed;
+        ff = TYPED_SGL_Q_e;
+    passed = test1(counter, ff, 2, 200000) && passed;
+        ff = SHM_e;
+    passed = test1(counter, ff, 2, 200000) && passed;
+        ff = DURABLE_e;
+    passed = test1(counter, ff, 2, 200000) && passed;
+        ff = TLCACHE_e;
+    passed = test1(counter, ff, 2, 200000) && passed;
+        ff = ELIM_e;
+    passed = test1(counter, ff, 2, 200000) && passed;
+        ff = FC_S_e;
+    passed = test1(counter, ff, 2, 200000) && passed;
+        ff = FC_Q_e;
+    passed = test1(counter, ff, 2, 200000) && passed;
+        ff = RING_e;
+    passed = test1(counter, ff, 2, 200000) && passed;
+        ff = SPSC_e;
+    passed = test1(counter, ff, 2, 200000) && passed;
     // 4 threads, 200000 elements
         ff = SGL_Q_e;
-    test1(counter, ff, 4, 200000);
+    passed = test1(counter, ff, 4, 200000) && passed;
         ff = SGL_S_e;
-    test1(counter, ff, 4, 200000);
+    passed = test1(counter, ff, 4, 200000) && passed;
         ff = TREIBER_e;
-    test1(counter, ff, 4, 200000);
+    passed = test1(counter, ff, 4, 200000) && passed;
+        ff = TREIBER_BATCH_e;
+    passed = test1(counter, ff, 4, 200000) && passed;
+        ff = TREIBER_DRAIN_e;
+    passed = test1(counter, ff, 4, 200000) && passed;
+        ff = TREIBER_POLICY_e;
+    passed = test1(counter, ff, 4, 200000) && passed;
         ff = ESGL_e;
-    test1(counter, ff, 4, 200000);
+    passed = test1(counter, ff, 4, 200000) && passed;
         ff = BASKET_e;
-    test1(counter, ff, 4, 200000);
+    passed = test1(counter, ff, 4, 200000) && passed;
+        ff = BASKET_WAIT_e;
+    passed = test1(counter, ff, 4, 200000) && passed;
         ff = MS_e;
-    test1(counter, ff, 4, 200000);
+    passed = test1(counter, ff, 4, 200000) && passed;
+        ff = MS_BATCH_e;
+    passed = test1(counter, ff, 4, 200000) && passed;
+        ff = MS_DRAIN_e;
+    passed = test1(counter, ff, 4, 200000) && passed;
+        ff = MS_WAIT_e;
+    passed = test1(counter, ff, 4, 200000) && passed;
+        ff = MS_POLICY_e;
+    passed = test1(counter, ff, 4, 200000) && passed;
+        ff = FAA_e;
+    passed = test1(counter, ff, 4, 200000) && passed;
+        ff = WFQ_e;
+    passed = test1(counter, ff, 4, 200000) && passed;
+        ff = MQ_e;
+    passed = test1(counter, ff, 4, 200000) && passed;
+        ff = WSDEQUE_e;
+    passed = test1(counter, ff, 4, 200000) && passed;
+        ff = PQ_e;
+    passed = test1(counter, ff, 4, 200000) && passed;
+        ff = SGL_PQ_e;
+    passed = test1(counter, ff, 4, 200000) && passed;
+        ff = BOUNDED_e;
+    passed = test1(counter, ff, 4, 200000) && passed;
+        ff = ITREIBER_e;
+    passed = test1(counter, ff, 4, 200000) && passed;
+        ff = IMS_e;
+    passed = test1(counter, ff, 4, 200000) && passed;
+        ff = TYPED_TREIBER_e;
+    passed = test1(counter, ff, 4, 200000) && passed;
+        ff = TYPED_MS_e;
+    passed = test1(counter, ff, 4, 200000) && passed;
+        ff = TYPED_SGL_S_e;
+    passed = test1(counter, ff, 4, 200000) && passed;
+        ff = TYPED_SGL_Q_e;
+    passed = test1(counter, ff, 4, 200000) && passed;
+        ff = SHM_e;
+    passed = test1(counter, ff, 4, 200000) && passed;
+        ff = DURABLE_e;
+    passed = test1(counter, ff, 4, 200000) && passed;
+        ff = TLCACHE_e;
+    passed = test1(counter, ff, 4, 200000) && passed;
+        ff = ELIM_e;
+    passed = test1(counter, ff, 4, 200000) && passed;
+        ff = FC_S_e;
+    passed = test1(counter, ff, 4, 200000) && passed;
+        ff = FC_Q_e;
+    passed = test1(counter, ff, 4, 200000) && passed;
+        ff = RING_e;
+    passed = test1(counter, ff, 4, 200000) && passed;
+        ff = SPSC_e;
+    passed = test1(counter, ff, 4, 200000) && passed;
+    return passed;
+}
+
+/******************************************************************************
+ * The treiber and ms runs of main, one instantiation per --policy
+ *****************************************************************************/ 
+template <class S>
+static void Main_Treiber(void)
+{
+    if (tlcacheSize > 0)
+    {
+        S TreiberStack;
+        Run_TLCache(&TreiberStack, numberThreads, true);
+        return;
+    }
+    pthread_t threads[numberThreads];
+    S TreiberStack;
+    TreiberStack.push(-2);
+    for (int numThreads = 0; numThreads < numberThreads; ++numThreads)
+    {
+        pthread_create(&threads[numThreads], NULL,
+                       (batchSize > 1) ? Treiber_Batch_ThreadHandler<S> : Treiber_ThreadHandler<S>, &TreiberStack); 
+    }
+    for (int numThreads = 0; numThreads < numberThreads; ++numThreads)
+    {
+        pthread_join(threads[numThreads], NULL); 
+    } 
+    TreiberStack.print();
+}
+
+template <class Q>
+static void Main_MS(void)
+{
+    pthread_t threads[numberThreads];
+    Q msqueueObject;  // Create the Object
+    for (int numThreads = 0; numThreads < numberThreads; ++numThreads)
+    {
+        pthread_create(&threads[numThreads], NULL,
+                       (batchSize > 1) ? MS_Batch_ThreadHandler<Q> : MS_ThreadHandler<Q>, &msqueueObject); 
+    }
+    for (int numThreads = 0; numThreads < numberThreads; ++numThreads)
+    {
+        pthread_join(threads[numThreads], NULL); 
+    }
+    msqueueObject.print();
+    msqueueObject.report();
 }
 
 int main(int argc, char* argv[]) 
 {
-    (void)argc;
+    // Pull out the --option=value flags so the positional arguments below
+    // keep their places no matter where the flags were given
+    char * args[argc + 1];
+    int numberArgs = 0;
+    for (int arg = 0; arg < argc; ++arg)
+    {
+        if (strncmp(argv[arg], "--reclaim=", 10) == 0)
+        {
+            if (!Reclaim_Select(argv[arg] + 10))
+            {
+                printf("Unknown reclaim scheme %s\n", argv[arg] + 10);
+                return -1;
+            }
+        }
+        else if (strncmp(argv[arg], "--capacity=", 11) == 0)
+        {
+            char *p;
+            ringCapacity = strtoul(argv[arg] + 11, &p, 10);
+        }
+        else if (strcmp(argv[arg], "--pairs") == 0)
+        {
+            pairMode = true;
+        }
+        else if (strncmp(argv[arg], "--batch=", 8) == 0)
+        {
+            char *p;
+            batchSize = strtol(argv[arg] + 8, &p, 10);
+            if (batchSize < 1)
+            {
+                batchSize = 1;
+            }
+        }
+        else if (strncmp(argv[arg], "--drain=", 8) == 0)
+        {
+            if (strcmp(argv[arg] + 8, "all") == 0)
+            {
+                drainAll = true;
+            }
+            else if (strcmp(argv[arg] + 8, "one") != 0)
+            {
+                printf("Unknown drain mode %s\n", argv[arg] + 8);
+                return -1;
+            }
+        }
+        else if (strncmp(argv[arg], "--backoff=", 10) == 0)
+        {
+            if (!Backoff_Select(argv[arg] + 10))
+            {
+                printf("Unknown backoff %s\n", argv[arg] + 10);
+                return -1;
+            }
+        }
+        else if (strncmp(argv[arg], "--backoff-cap=", 14) == 0)
+        {
+            char *p;
+            unsigned long cap = strtoul(argv[arg] + 14, &p, 10);
+            if (*p != '\0' || cap > BACKOFF_CAP_MAX)
+            {
+                printf("Unknown backoff cap %s\n", argv[arg] + 14);
+                return -1;
+            }
+            backoffCap = cap;
+        }
+        else if (strncmp(argv[arg], "--shards=", 9) == 0)
+        {
+            char *p;
+            mqShards = strtol(argv[arg] + 9, &p, 10);
+        }
+        else if (strncmp(argv[arg], "--tlcache=", 10) == 0)
+        {
+            char *p;
+            tlcacheSize = strtoul(argv[arg] + 10, &p, 10);
+        }
+        else if (strncmp(argv[arg], "--staleness=", 12) == 0)
+        {
+            char *p;
+            tlcacheStaleness = strtoul(argv[arg] + 12, &p, 10);
+        }
+        else if (strncmp(argv[arg], "--file=", 7) == 0)
+        {
+            durablePath = argv[arg] + 7;
+        }
+        else if (strncmp(argv[arg], "--shm=", 6) == 0)
+        {
+            shmName = argv[arg] + 6;
+            if (shmName[0] != '/')
+            {
+                printf("Unknown shm %s\n", shmName);
+                return -1;
+            }
+        }
+        else if (strncmp(argv[arg], "--segment=", 10) == 0)
+        {
+            char *p;
+            faaSegment = strtol(argv[arg] + 10, &p, 10);
+            if (faaSegment < FAA_MIN_NODE || faaSegment > FAA_NODE_SIZE)
+            {
+                printf("Unknown segment %s\n", argv[arg] + 10);
+                return -1;
+            }
+        }
+        else if (strncmp(argv[arg], "--producers=", 12) == 0)
+        {
+            char *p;
+            producerCount = strtol(argv[arg] + 12, &p, 10);
+        }
+        else if (strncmp(argv[arg], "--wait=", 7) == 0)
+        {
+            if (strcmp(argv[arg] + 7, "poll") == 0)
+            {
+                parkWait = false;
+            }
+            else if (strcmp(argv[arg] + 7, "park") != 0)
+            {
+                printf("Unknown wait mode %s\n", argv[arg] + 7);
+                return -1;
+            }
+        }
+        else if (strncmp(argv[arg], "--payload=", 10) == 0)
+        {
+            char *p;
+            payloadSize = strtol(argv[arg] + 10, &p, 10);
+            if (payloadSize != 4 && payloadSize != 64 && payloadSize != 128 && payloadSize != 256 && payloadSize != 512)
+            {
+                printf("Unsupported payload %s\n", argv[arg] + 10);
+                return -1;
+            }
+        }
+        else if (strcmp(argv[arg], "--wrapped") == 0)
+        {
+            wrappedPayload = true;
+        }
+        else if (strncmp(argv[arg], "--policy=", 9) == 0)
+        {
+            if (!Policy_Select(argv[arg] + 9))
+            {
+                printf("Unknown policy %s\n", argv[arg] + 9);
+                return -1;
+            }
+        }
+        else if (strncmp(argv[arg], "--alloc=", 8) == 0)
+        {
+            if (!Pool_Select(argv[arg] + 8))
+            {
+                printf("Unknown allocator %s\n", argv[arg] + 8);
+                return -1;
+            }
+        }
+        else
+        {
+            args[numberArgs++] = argv[arg];
+        }
+    }
+    args[numberArgs] = NULL;
+    argv = args;
     // Create the pthread mutex used in SGL
     if (pthread_mutex_init(&singleGlobalLock, NULL) != 0)
     {
@@ -567,7 +3357,34 @@ int main(int argc, char* argv[])
             printf("Normal single run command:\n");
             printf("    ./containers -t <# threads> -l <# loops/iterations> <above>\n");
             printf("    <above> could be any of the following:\n");
-            printf("    treiber, ms, e_sgl, e_t, basket, sglqueue, sglstack\n");
+            printf("    treiber, ms, e_sgl, e_t, elim, basket, sglqueue, sglstack, fcstack, fcqueue, ring, spsc, faa, wfq, mq, wsdeque, pq, sglpq, bounded, itreiber, ims,\n");
+            printf("    gtreiber, gms, gsglstack, gsglqueue, shm, durable\n");
+            printf("    --reclaim=hp|ebr|none picks the memory reclamation scheme (default hp)\n");
+            printf("    --alloc=pool|new uses the per-thread node pool or plain new (default new)\n");
+            printf("    --capacity=N sets the ring's and bounded's slot count, rounded up to a power of two,\n");
+            printf("                 and shm's node count\n");
+            printf("    --pairs runs ms as producer/consumer pairs like spsc\n");
+            printf("    --batch=N moves N elements per batch operation in treiber, ms and spsc,\n");
+            printf("              and commits every N operations in durable (default 1)\n");
+            printf("    --tlcache=N puts an N element thread-local cache in front of treiber's and elim's stack\n");
+            printf("    --staleness=N spills cached elements older than N of the thread's operations (default %d)\n", TLC_STALENESS);
+            printf("    --file=PATH keeps durable's queue in PATH across runs instead of a scratch file\n");
+            printf("    --drain=all empties treiber and ms with one pop_all/dequeue_all per thread\n");
+            printf("    --policy=seqcst|acqrel|seqcst_padded|acqrel_padded picks the treiber/ms instantiation\n");
+            printf("    --backoff=none|exp|yield sets what a thread does after a failed CAS (default none)\n");
+            printf("        and how basket, elim and fc wait, which use exp under none\n");
+            printf("    --backoff-cap=N pause loops before exp starts yielding (default 1024, at most 1048576)\n");
+            printf("    --shards=N sets mq's shard count (default %d per thread)\n", MQ_SHARDS_PER_THREAD);
+            printf("    --segment=N sets faa's slots per segment, %d to %d (default %d)\n", FAA_MIN_NODE, FAA_NODE_SIZE, FAA_NODE_SIZE);
+            printf("    --producers=N runs ms, basket or bounded with N producers and the other threads consuming\n");
+            printf("                  (shm forks N producer processes and the rest as consumers, default half)\n");
+            printf("                  (bounded defaults to three producers per consumer)\n");
+            printf("    --payload=4|64|128|256|512 bytes per gtreiber/gms/gsglstack/gsglqueue element,\n");
+            printf("                  64 up for itreiber/ims (default 64)\n");
+            printf("    --wrapped runs the itreiber/ims payloads through tstack/msqueue nodes instead\n");
+            printf("    --shm=/NAME runs shm in a named POSIX shm region the children attach to,\n");
+            printf("                instead of an anonymous memfd region they inherit\n");
+            printf("    --wait=poll|park idle consumers of --producers poll or park in dequeue_wait (default park)\n");
             printf("\n");
             printf("Automated Test Command\n");
             printf("    ./containers test\n");
@@ -640,34 +3457,78 @@ int main(int argc, char* argv[])
     }
     else if (strcmp(argv[5], "treiber") == 0)
     {
-        // Treiber Stack
-    	tstack TreiberStack;
-        TreiberStack.push(-2);
-	    for (int numThreads = 0; numThreads < numberThreads; ++numThreads)
-	    {
-	        pthread_create(&threads[numThreads], NULL, Treiber_ThreadHandler, &TreiberStack); 
-	    }
-	    for (int numThreads = 0; numThreads < numberThreads; ++numThreads)
-	    {
-	        pthread_join(threads[numThreads], NULL); 
-	    } 
-            TreiberStack.print();
-
+        // Treiber Stack, the --policy instantiation
+        switch (containerPolicy)
+        {
+            case(POLICY_SEQCST_e):        Main_Treiber< basic_tstack<seqcst_policy> >();        break;
+            case(POLICY_ACQREL_e):        Main_Treiber< basic_tstack<acqrel_policy> >();        break;
+            case(POLICY_SEQCST_PADDED_e): Main_Treiber< basic_tstack<seqcst_padded_policy> >(); break;
+            case(POLICY_ACQREL_PADDED_e): Main_Treiber< basic_tstack<acqrel_padded_policy> >(); break;
+            default:                      Main_Treiber<tstack>();                               break;
+        }
 	}
+    else if (strcmp(argv[5], "spsc") == 0 ||
+             (strcmp(argv[5], "ms") == 0 && pairMode))
+    {
+        // SPSC Rings or MS queues, one per producer/consumer pair
+        if (!Run_Pairs(strcmp(argv[5], "spsc") == 0, (numberThreads < 2) ? 1 : numberThreads / 2))
+        {
+            printf("Lost or duplicated elements\n");
+        }
+    }
+    else if ((strcmp(argv[5], "ms") == 0 || strcmp(argv[5], "basket") == 0) && producerCount > 0)
+    {
+        // MS or Basket queue, fewer producers than consumers
+        if (producerCount >= numberThreads)
+        {
+            printf("--producers must leave at least one consumer\n");
+            return -1;
+        }
+        Run_Waiters((strcmp(argv[5], "basket") == 0) ? BASKET_WAIT_e : MS_WAIT_e,
+                    producerCount, numberThreads - producerCount, true);
+    }
+    else if (strcmp(argv[5], "durable") == 0)
+    {
+        // Durable Two-Lock Queue, committing every --batch operations
+        Run_Durable(numberThreads, true);
+    }
+    else if (strcmp(argv[5], "shm") == 0)
+    {
+        // Inter-process MS queue, half the processes producing unless
+        // --producers says otherwise
+        int producers = (producerCount > 0) ? producerCount : numberThreads / 2;
+        if (producers < 1)
+        {
+            producers = 1;
+        }
+        int consumers = (numberThreads - producers < 1) ? 1 : numberThreads - producers;
+        if (!Run_Processes(producers, consumers, shmName, true))
+        {
+            printf("Lost or duplicated elements\n");
+        }
+    }
+    else if (strcmp(argv[5], "bounded") == 0)
+    {
+        // Bounded Blocking Queue, producer heavy unless --producers says otherwise
+        int producers = (producerCount > 0) ? producerCount : (3 * numberThreads) / 4;
+        if (producers < 1)
+        {
+            producers = 1;
+        }
+        int consumers = (numberThreads - producers < 1) ? 1 : numberThreads - producers;
+        Run_Waiters(BOUNDED_e, producers, consumers, true);
+    }
     else if (strcmp(argv[5], "ms") == 0)
     {
-	    // MS queue
-	    msqueue msqueueObject;  // Create the Object
-	    for (int numThreads = 0; numThreads < numberThreads; ++numThreads)
-	    {
-	        pthread_create(&threads[numThreads], NULL, MS_ThreadHandler, &msqueueObject); 
-	    }
-	    for (int numThreads = 0; numThreads < numberThreads; ++numThreads)
-	    {
-	        pthread_join(threads[numThreads], NULL); 
-	    }
-        msqueueObject.print();
-
+	    // MS queue, the --policy instantiation
+        switch (containerPolicy)
+        {
+            case(POLICY_SEQCST_e):        Main_MS< basic_msqueue<seqcst_policy> >();        break;
+            case(POLICY_ACQREL_e):        Main_MS< basic_msqueue<acqrel_policy> >();        break;
+            case(POLICY_SEQCST_PADDED_e): Main_MS< basic_msqueue<seqcst_padded_policy> >(); break;
+            case(POLICY_ACQREL_PADDED_e): Main_MS< basic_msqueue<acqrel_padded_policy> >(); break;
+            default:                      Main_MS<msqueue>();                               break;
+        }
 	}
     else if (strcmp(argv[5], "basket") == 0)
     {
@@ -682,6 +3543,7 @@ int main(int argc, char* argv[])
 	    {
 	        pthread_join(threads[numThreads], NULL); 
 	    }
+	    destroy_queue(queueInput);
 	    delete queueInput;
 	}
     else if (strcmp(argv[5], "e_sgl") == 0)
@@ -722,6 +3584,186 @@ int main(int argc, char* argv[])
             pthread_join(threads[numThreads], NULL); 
         }
     }
+    else if (strcmp(argv[5], "elim") == 0)
+    {
+        // Elimination Backoff Stack, one collision slot per pair of threads
+        elimstack elimObject(numberThreads / 2);
+        if (tlcacheSize > 0)
+        {
+            Run_TLCache(&elimObject, numberThreads, true);
+        }
+        else
+        {
+            for (int numThreads = 0; numThreads < numberThreads; ++numThreads)
+            {
+                pthread_create(&threads[numThreads], NULL, Elim_ThreadHandler, &elimObject); 
+            }
+            for (int numThreads = 0; numThreads < numberThreads; ++numThreads)
+            {
+                pthread_join(threads[numThreads], NULL); 
+            }
+        }
+        elimObject.report();
+    }
+    else if (strcmp(argv[5], "faa") == 0)
+    {
+        // Fetch-and-Add Array Queue
+        faaqueue faaObject(faaSegment);
+        for (int numThreads = 0; numThreads < numberThreads; ++numThreads)
+        {
+            pthread_create(&threads[numThreads], NULL, Queue_ThreadHandler<faaqueue>, &faaObject); 
+        }
+        for (int numThreads = 0; numThreads < numberThreads; ++numThreads)
+        {
+            pthread_join(threads[numThreads], NULL); 
+        }
+        faaObject.report();
+    }
+    else if (strcmp(argv[5], "wfq") == 0)
+    {
+        // Wait-Free Queue
+        wfqueue * wfqObject = new wfqueue;
+        for (int numThreads = 0; numThreads < numberThreads; ++numThreads)
+        {
+            pthread_create(&threads[numThreads], NULL, Queue_ThreadHandler<wfqueue>, wfqObject); 
+        }
+        for (int numThreads = 0; numThreads < numberThreads; ++numThreads)
+        {
+            pthread_join(threads[numThreads], NULL); 
+        }
+        wfqObject->report();
+        delete wfqObject;
+    }
+    else if (strcmp(argv[5], "mq") == 0)
+    {
+        // Relaxed FIFO MultiQueue
+        multiqueue mqObject((mqShards > 0) ? mqShards : MQ_SHARDS_PER_THREAD * numberThreads);
+        vector<mq_stamps> stamps;
+        mqStruct threadPassIn;
+        threadPassIn.mq = &mqObject;
+        threadPassIn.stamps = &stamps;
+        pthread_mutex_init(&threadPassIn.lock, NULL);
+        for (int numThreads = 0; numThreads < numberThreads; ++numThreads)
+        {
+            pthread_create(&threads[numThreads], NULL, MQ_ThreadHandler, &threadPassIn); 
+        }
+        for (int numThreads = 0; numThreads < numberThreads; ++numThreads)
+        {
+            pthread_join(threads[numThreads], NULL); 
+        }
+        pthread_mutex_destroy(&threadPassIn.lock);
+        double mean;
+        unsigned long long max;
+        MQ_RankError(stamps, &mean, &max);
+        printf("Rank error mean: %f max: %llu shards: %d\n", mean, max, mqObject.shards());
+    }
+    else if (strcmp(argv[5], "wsdeque") == 0)
+    {
+        // Work-Stealing Deques, one per thread
+        Run_Steal(numberThreads, WSD_CAPACITY, true);
+    }
+    else if (strcmp(argv[5], "pq") == 0)
+    {
+        // Skiplist Priority Queue
+        skiplistpq pqObject;
+        for (int numThreads = 0; numThreads < numberThreads; ++numThreads)
+        {
+            pthread_create(&threads[numThreads], NULL, PQ_ThreadHandler, &pqObject); 
+        }
+        for (int numThreads = 0; numThreads < numberThreads; ++numThreads)
+        {
+            pthread_join(threads[numThreads], NULL); 
+        }
+    }
+    else if (strcmp(argv[5], "sglpq") == 0)
+    {
+        // SGL Priority Queue
+        minQueue minPQ;
+        sglPQStruct pqStruct;
+        pqStruct.minPQ = &minPQ;
+        pqStruct.loops = numberLoops;
+        for (int numThreads = 0; numThreads < numberThreads; ++numThreads)
+        {
+            pthread_create(&threads[numThreads], NULL, SGL_PQ_ThreadHandler, &pqStruct); 
+        }
+        for (int numThreads = 0; numThreads < numberThreads; ++numThreads)
+        {
+            pthread_join(threads[numThreads], NULL); 
+        }
+    }
+    else if (strcmp(argv[5], "itreiber") == 0 || strcmp(argv[5], "ims") == 0)
+    {
+        // Intrusive Treiber Stack or MS queue, or the wrapped comparison
+        if (payloadSize < 64)
+        {
+            printf("itreiber and ims need a payload of 64 bytes or more\n");
+            return -1;
+        }
+        Run_Intrusive(strcmp(argv[5], "ims") == 0, numberThreads);
+        printf("Payload: %d bytes %s\n", payloadSize, wrappedPayload ? "wrapped" : "intrusive");
+    }
+    else if (strcmp(argv[5], "gtreiber") == 0 || strcmp(argv[5], "gms") == 0 ||
+             strcmp(argv[5], "gsglstack") == 0 || strcmp(argv[5], "gsglqueue") == 0)
+    {
+        // Typed Treiber Stack, MS queue or SGL Stack/Queue
+        int which = TYPED_SGL_Q_e;
+        if (strcmp(argv[5], "gtreiber") == 0)
+        {
+            which = TYPED_TREIBER_e;
+        }
+        else if (strcmp(argv[5], "gms") == 0)
+        {
+            which = TYPED_MS_e;
+        }
+        else if (strcmp(argv[5], "gsglstack") == 0)
+        {
+            which = TYPED_SGL_S_e;
+        }
+        Run_Typed(which, numberThreads);
+        printf("Payload: %d bytes\n", payloadSize);
+    }
+    else if (strcmp(argv[5], "ring") == 0)
+    {
+        // Bounded MPMC Ring Queue
+        ringqueue ringObject(ringCapacity);
+        for (int numThreads = 0; numThreads < numberThreads; ++numThreads)
+        {
+            pthread_create(&threads[numThreads], NULL, Ring_ThreadHandler, &ringObject); 
+        }
+        for (int numThreads = 0; numThreads < numberThreads; ++numThreads)
+        {
+            pthread_join(threads[numThreads], NULL); 
+        }
+        printf("Ring capacity: %zu full: %lu\n", ringObject.capacity(), ringFull.load());
+    }
+    else if (strcmp(argv[5], "fcstack") == 0)
+    {
+        // Flat Combining Stack
+        fcstack fcStackObject;
+        for (int numThreads = 0; numThreads < numberThreads; ++numThreads)
+        {
+            pthread_create(&threads[numThreads], NULL, FC_Stack_ThreadHandler, &fcStackObject); 
+        }
+        for (int numThreads = 0; numThreads < numberThreads; ++numThreads)
+        {
+            pthread_join(threads[numThreads], NULL); 
+        }
+        fcStackObject.report();
+    }
+    else if (strcmp(argv[5], "fcqueue") == 0)
+    {
+        // Flat Combining Queue
+        fcqueue fcQueueObject;
+        for (int numThreads = 0; numThreads < numberThreads; ++numThreads)
+        {
+            pthread_create(&threads[numThreads], NULL, FC_Queue_ThreadHandler, &fcQueueObject); 
+        }
+        for (int numThreads = 0; numThreads < numberThreads; ++numThreads)
+        {
+            pthread_join(threads[numThreads], NULL); 
+        }
+        fcQueueObject.report();
+    }
 
     clock_gettime(CLOCK_MONOTONIC,&endTime);
     unsigned long long elapsed_ns;
@@ -729,6 +3771,15 @@ int main(int argc, char* argv[])
     printf("Elapsed (ns): %llu\n",elapsed_ns);
     double elapsed_s = ((double)elapsed_ns)/1000000000.0;
     printf("Elapsed (s): %lf\n",elapsed_s);
+    Reclaim_Report();   // Counted during the run, before the leftovers are flushed
+    Reclaim_Flush();
+    Pool_Report();
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    printf("Peak RSS (KB): %ld\n", usage.ru_maxrss);
+    printf("Page faults: %ld\n", usage.ru_minflt + usage.ru_majflt);
+    printf("CPU (s): %lf\n", usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+                              (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000000.0);
 
     return 1;
 }
\ No newline at end of file
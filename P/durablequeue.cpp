@@ -0,0 +1,368 @@
+#include "durablequeue.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__x86_64__)
+#include <immintrin.h>  // _mm_clflush, _mm_clflushopt, _mm_sfence
+#endif
+
+/******************************************************************************
+ * Durable Two-Lock Queue
+ * Credit goes to Maged Michael and Michael Scott - "Simple, Fast, and
+ * Practical Non-Blocking and Blocking Concurrent Queue Algorithms" for the
+ * two-lock queue the log is driven by
+ *****************************************************************************/
+
+/******************************************************************************
+ * @brief durablequeue::Open - Maps the queue file, laying out an empty queue
+ *                             if the file is new or empty and recovering it
+ *                             if it holds one. Any other file is refused
+ *                             untouched, so a wrong path never wipes data.
+ * @param path     - the file
+ *        capacity - records in a new log, rounded up to a power of two. An
+ *                   existing file keeps its own.
+ *        batch    - operations between group commits, 1 commits every one
+ * @return durablequeue * - the queue, NULL if the file could not be used
+ *****************************************************************************/
+durablequeue * durablequeue::Open(const char * path, size_t capacity, size_t batch)
+{
+    int fd = open(path, O_RDWR | O_CREAT, 0600);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    struct stat st;
+    header existing;
+    memset(&existing, 0, sizeof(existing));
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return NULL;
+    }
+    bool fresh = st.st_size == 0;
+    size_t records = 2;
+    if (fresh)
+    {
+        while (records < capacity)
+        {
+            records <<= 1;
+        }
+    }
+    else
+    {
+        // Not ours, or never finished being laid out, leave it alone
+        if (st.st_size < DQ_HEADER ||
+            pread(fd, &existing, sizeof(existing), 0) != sizeof(existing) ||
+            existing.magic != DQ_MAGIC)
+        {
+            close(fd);
+            return NULL;
+        }
+        records = existing.capacity;
+        if (records < 2 || (records & (records - 1)) != 0 ||
+            (size_t)st.st_size != DQ_HEADER + records * sizeof(uint64_t))
+        {
+            close(fd);
+            return NULL;
+        }
+    }
+    size_t size = DQ_HEADER + records * sizeof(uint64_t);
+    if (fresh && (ftruncate(fd, size) != 0 || fsync(fd) != 0))
+    {
+        close(fd);
+        return NULL;
+    }
+    bool dax = false;
+    void * region = MAP_FAILED;
+#if defined(MAP_SYNC) && defined(MAP_SHARED_VALIDATE)
+    // Only DAX files take MAP_SYNC, and only there do cache flushes persist
+    region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED_VALIDATE | MAP_SYNC, fd, 0);
+    dax = region != MAP_FAILED;
+#endif
+    if (region == MAP_FAILED)
+    {
+        region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (region == MAP_FAILED)
+    {
+        return NULL;
+    }
+    durablequeue * q = new durablequeue;
+    q->hdr = (header *)region;
+    q->log = (atomic<uint64_t> *)((char *)region + DQ_HEADER);
+    q->bytes = size;
+    q->mask = records - 1;
+    q->shift = 0;
+    while (((size_t)1 << q->shift) < records)
+    {
+        ++q->shift;
+    }
+    q->batchSize = (batch < 1) ? 1 : batch;
+    q->dax = dax;
+    q->commits = 0;
+    pthread_mutex_init(&q->tailLock, NULL);
+    pthread_mutex_init(&q->headLock, NULL);
+    pthread_mutex_init(&q->commitLock, NULL);
+    if (fresh)
+    {
+        // Lay out the header first, the magic only goes in once it is down
+        q->hdr->capacity = records;
+        q->hdr->head = 0;
+        q->Flush(q->hdr, sizeof(header));
+        __atomic_store_n(&q->hdr->magic, DQ_MAGIC, __ATOMIC_RELEASE);
+        q->Flush(&q->hdr->magic, sizeof(uint64_t));
+    }
+    q->Recover();
+    return q;
+}
+
+/******************************************************************************
+ * @brief durablequeue::Close - Commits whatever is outstanding and unmaps
+ *                              the file
+ * @param q - from Open
+ * @return none
+ *****************************************************************************/
+void durablequeue::Close(durablequeue * q)
+{
+    q->commit();
+    munmap(q->hdr, q->bytes);
+    pthread_mutex_destroy(&q->tailLock);
+    pthread_mutex_destroy(&q->headLock);
+    pthread_mutex_destroy(&q->commitLock);
+    delete q;
+}
+
+/******************************************************************************
+ * @brief durablequeue::Recover - Takes the committed head from the header
+ *                                and walks forward over every record
+ *                                stamped with the lap its slot expects.
+ *                                Records past the first gap that still
+ *                                carry a valid stamp are cleared, or
+ *                                refilling the gap would bring them back.
+ * @param none
+ * @return none
+ *****************************************************************************/
+void durablequeue::Recover()
+{
+    uint64_t h = __atomic_load_n(&hdr->head, __ATOMIC_ACQUIRE);
+    uint64_t n = h;
+    while (n - h <= mask && (log[n & mask].load(memory_order_relaxed) >> 32) == (Record(n, 0) >> 32))
+    {
+        ++n;
+    }
+    bool cleared = false;
+    for (uint64_t p = n + 1; p - h <= mask; ++p)
+    {
+        if ((log[p & mask].load(memory_order_relaxed) >> 32) == (Record(p, 0) >> 32))
+        {
+            log[p & mask].store(0, memory_order_relaxed);
+            cleared = true;
+        }
+    }
+    if (cleared)
+    {
+        FlushLog(n, h + mask + 1);
+    }
+    head.store(h, memory_order_relaxed);
+    tail.store(n, memory_order_relaxed);
+    durableHead.store(h, memory_order_relaxed);
+    durableTail.store(n, memory_order_relaxed);
+    recoveredCount = n - h;
+}
+
+/******************************************************************************
+ * @brief durablequeue::Record - Packs val with the stamp for log position n
+ * @param n   - position in the log, counting every record ever appended
+ *        val - the value
+ * @return uint64_t - the lap of n plus one in the top half, val below
+ *****************************************************************************/
+uint64_t durablequeue::Record(uint64_t n, int val)
+{
+    return ((uint64_t)(uint32_t)((n >> shift) + 1) << 32) | (uint32_t)val;
+}
+
+/******************************************************************************
+ * @brief durablequeue::enqueue - Appends val and commits if it completes
+ *                                a batch
+ * @param val - the value being enqueued
+ * @return bool - false if the log is full
+ *****************************************************************************/
+bool durablequeue::enqueue(int val)
+{
+    pthread_mutex_lock(&tailLock);
+    uint64_t t = tail.load(memory_order_relaxed);
+    if (t - durableHead.load(memory_order_acquire) > mask)
+    {
+        // A slot the consumer freed since the last commit must not be
+        // reused before that head is in the file, or recovery would start
+        // at it and stop straight away
+        pthread_mutex_unlock(&tailLock);
+        if (t - head.load(memory_order_acquire) > mask)
+        {
+            return false;
+        }
+        commit();
+        pthread_mutex_lock(&tailLock);
+        t = tail.load(memory_order_relaxed);
+        if (t - durableHead.load(memory_order_acquire) > mask)
+        {
+            pthread_mutex_unlock(&tailLock);
+            return false;
+        }
+    }
+    log[t & mask].store(Record(t, val), memory_order_relaxed);
+    tail.store(t + 1, memory_order_release);
+    pthread_mutex_unlock(&tailLock);
+    if (t + 1 - durableTail.load(memory_order_relaxed) >= batchSize)
+    {
+        Commit(t + 1);
+    }
+    return true;
+}
+
+/******************************************************************************
+ * @brief durablequeue::dequeue - Takes the oldest value and commits if that
+ *                                completes a batch
+ * @param none
+ * @return int - the value, -2 if the queue is empty
+ *****************************************************************************/
+int durablequeue::dequeue()
+{
+    pthread_mutex_lock(&headLock);
+    uint64_t h = head.load(memory_order_relaxed);
+    if (h == tail.load(memory_order_acquire))
+    {
+        pthread_mutex_unlock(&headLock);
+        return -2;
+    }
+    int val = (int)(uint32_t)log[h & mask].load(memory_order_relaxed);
+    head.store(h + 1, memory_order_release);
+    pthread_mutex_unlock(&headLock);
+    if (h + 1 - durableHead.load(memory_order_relaxed) >= batchSize)
+    {
+        Commit(0);
+    }
+    return val;
+}
+
+/******************************************************************************
+ * @brief durablequeue::commit - Makes everything appended or consumed so far
+ *                               durable
+ * @param none
+ * @return none
+ *****************************************************************************/
+void durablequeue::commit()
+{
+    Commit(UINT64_MAX);
+}
+
+/******************************************************************************
+ * @brief durablequeue::Commit - Group commit. Flushes every record appended
+ *                               so far, then the head. A caller whose
+ *                               records someone else already flushed
+ *                               returns without flushing anything.
+ * @param upTo - the log position the caller needs durable, 0 for a
+ *               dequeuer and UINT64_MAX to force a commit
+ * @return none
+ *****************************************************************************/
+void durablequeue::Commit(uint64_t upTo)
+{
+    pthread_mutex_lock(&commitLock);
+    if ((upTo == 0 && head.load(memory_order_relaxed) - durableHead.load(memory_order_relaxed) < batchSize) ||
+        (upTo != 0 && upTo != UINT64_MAX && durableTail.load(memory_order_relaxed) >= upTo))
+    {
+        pthread_mutex_unlock(&commitLock);
+        return;
+    }
+    // Head first, so the records up to it are part of this flush too
+    uint64_t h = head.load(memory_order_acquire);
+    uint64_t t = tail.load(memory_order_acquire);
+    FlushLog(durableTail.load(memory_order_relaxed), t);
+    durableTail.store(t, memory_order_release);
+    if (h != durableHead.load(memory_order_relaxed))
+    {
+        __atomic_store_n(&hdr->head, h, __ATOMIC_RELEASE);
+        Flush(&hdr->head, sizeof(uint64_t));
+        durableHead.store(h, memory_order_release);
+    }
+    ++commits;
+    pthread_mutex_unlock(&commitLock);
+}
+
+/******************************************************************************
+ * @brief durablequeue::FlushLog - Flushes log positions from up to to, in
+ *                                 two pieces if they wrap
+ *****************************************************************************/
+void durablequeue::FlushLog(uint64_t from, uint64_t to)
+{
+    if (from >= to)
+    {
+        return;
+    }
+    uint64_t count = to - from;
+    uint64_t start = from & mask;
+    uint64_t first = (count < mask + 1 - start) ? count : mask + 1 - start;
+    Flush(&log[start], first * sizeof(uint64_t));
+    if (count > first)
+    {
+        Flush(&log[0], (count - first) * sizeof(uint64_t));
+    }
+}
+
+/******************************************************************************
+ * @brief durablequeue::Flush - Writes addr..addr+len back to the file, line
+ *                              by line on DAX and page by page otherwise
+ *****************************************************************************/
+void durablequeue::Flush(const void * addr, size_t len)
+{
+#if defined(__x86_64__)
+    if (dax)
+    {
+        for (uintptr_t line = (uintptr_t)addr & ~(uintptr_t)(CACHE_LINE - 1);
+             line < (uintptr_t)addr + len; line += CACHE_LINE)
+        {
+#if defined(__CLFLUSHOPT__)
+            _mm_clflushopt((void *)line);
+#else
+            _mm_clflush((const void *)line);
+#endif
+        }
+        _mm_sfence();
+        return;
+    }
+#endif
+    static const uintptr_t pageSize = sysconf(_SC_PAGESIZE);
+    uintptr_t page = (uintptr_t)addr & ~(pageSize - 1);
+    msync((void *)page, (uintptr_t)addr + len - page, MS_SYNC);
+}
+
+uint64_t durablequeue::durable_tail()
+{
+    return durableTail.load(memory_order_acquire);
+}
+
+uint64_t durablequeue::durable_head()
+{
+    return durableHead.load(memory_order_acquire);
+}
+
+size_t durablequeue::recovered()
+{
+    return recoveredCount;
+}
+
+/******************************************************************************
+ * @brief durablequeue::report - Prints the log size, what Open recovered,
+ *                               how many commits ran and how they flushed
+ * @param none
+ * @return none
+ *****************************************************************************/
+void durablequeue::report()
+{
+    printf("Durable records: %llu recovered: %zu batch: %zu commits: %llu flush: %s\n",
+           (unsigned long long)(mask + 1), recoveredCount, batchSize, commits, dax ? "clflush" : "msync");
+}
@@ -0,0 +1,87 @@
+#ifndef DURABLEQUEUE_H
+#define DURABLEQUEUE_H
+
+#include <atomic>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "ringqueue.h"  // CACHE_LINE
+
+using namespace std;
+
+#define DQ_MAGIC  0x4455524142514555ULL // "DURABQEU", set once the file is laid out
+#define DQ_HEADER 4096                  // Header bytes in front of the log, one page
+
+/******************************************************************************
+ * Durable Two-Lock Queue
+ * A queue kept in a file mapped with mmap, so its contents survive the
+ * process. The file is a one-page header holding the consumer's position,
+ * followed by a circular log of 8-byte records. Each record holds the
+ * value and a stamp naming the lap of the log it was written on, and it is
+ * written with a single 8-byte store, so no record is ever half written.
+ * Recovery starts at the header's head and takes records for as long as
+ * their stamps match, which gives the longest run that reached the file
+ * intact. No tail has to be persisted, and nothing written past a crash
+ * can be mistaken for data. Open only lays a queue out in a new or empty
+ * file and refuses anything else without the magic.
+ *
+ * Enqueuers share one lock and dequeuers another, as in Michael and
+ * Scott's two-lock queue. Neither lock is held while anything is flushed.
+ * Group commit: a flush is only issued every batch operations, and it
+ * covers everything appended or consumed so far. Threads whose records
+ * are already covered skip it, so one msync or fsync serves the whole
+ * batch. A value is durable once durable_tail() passes it, and commit()
+ * forces that. The consumer side is at-least-once: values dequeued after
+ * the last commit come back after a crash.
+ *
+ * Dirty lines are written back with clflushopt (or clflush) plus sfence
+ * when the file could be mapped MAP_SYNC, which is only true on DAX
+ * persistent memory. Otherwise msync writes back the covering pages.
+ *****************************************************************************/
+class durablequeue
+{
+public:
+    struct header
+    {
+        uint64_t magic;
+        uint64_t capacity;      // Records in the log, a power of two
+        uint64_t head;          // First record not yet consumed, as of the last commit
+    };
+    static durablequeue * Open(const char * path, size_t capacity, size_t batch);
+    static void Close(durablequeue * q);
+    bool enqueue(int val);
+    int dequeue();
+    void commit();
+    uint64_t durable_tail();
+    uint64_t durable_head();
+    size_t recovered();
+    void report();
+private:
+    header * hdr;
+    atomic<uint64_t> * log;
+    size_t bytes;
+    uint64_t mask;
+    int shift;
+    size_t batchSize;
+    bool dax;
+    size_t recoveredCount;
+    char pad0[CACHE_LINE];
+    pthread_mutex_t tailLock;
+    atomic<uint64_t> tail;
+    char pad1[CACHE_LINE];
+    pthread_mutex_t headLock;
+    atomic<uint64_t> head;
+    char pad2[CACHE_LINE];
+    pthread_mutex_t commitLock;
+    atomic<uint64_t> durableTail;
+    atomic<uint64_t> durableHead;
+    unsigned long long commits;
+    durablequeue() {}
+    uint64_t Record(uint64_t n, int val);
+    void Commit(uint64_t upTo);
+    void Flush(const void * addr, size_t len);
+    void FlushLog(uint64_t from, uint64_t to);
+    void Recover();
+};
+
+#endif
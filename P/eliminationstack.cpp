@@ -74,6 +74,22 @@ void elim_init(void)
 	}
 
 }
+estack::estack()
+{
+    top.store(NULL);
+}
+
+estack::~estack()
+{
+    node * t = top.load(memory_order_relaxed);
+    while (t != NULL)
+    {
+        node * down = t->down;
+        delete t;
+        t = down;
+    }
+}
+
 /******************************************************************************
  * @brief estack::push - Customized treiber stack but with a limiter on top
  * @param val - the value wanting to be popped
@@ -90,13 +106,18 @@ bool estack::push(int val)
         return true;
     }
     node * n = new node(val);
-
-    do 
+    backoff b;
+    while (true)
     {
         t = top.load(memory_order_acquire);
 
         n->down = t;
-    } while (!top.compare_exchange_weak(t,n,memory_order_acq_rel));
+        if (top.compare_exchange_weak(t,n,memory_order_acq_rel))
+        {
+            break;
+        }
+        b.pause();
+    }
     return false;
     // printf("Elimination-Push:%d\n", val);
 }
@@ -112,161 +133,294 @@ int estack::pop()
     node * t;
     node * n;
     int v = 0;
-    do
+    backoff b;
+    Reclaim_Enter();
+    while (true)
     {
-        t = top.load(memory_order_acquire);
+        t = Reclaim_Protect(0, top);
         if (t == NULL)
         {
+            Reclaim_Exit();
             return -2;
         }
         n = t->down;
         v = t->val;
-    } while (!top.compare_exchange_weak(t,n,memory_order_acq_rel));
+        if (top.compare_exchange_weak(t,n,memory_order_acq_rel))
+        {
+            break;
+        }
+        b.pause();
+    }
+    Reclaim_Exit();
+    Reclaim_Retire(t);
     return v;
 }
 
-/*// Elimination Prototypes, the actual one from the paper
-struct Cell {
-    Cell *pnext;
-    void * pdata;
-};
-struct ThreadInfo {
-    uint16_t id;
-    char op;
-    Cell cell;
-    int spin;
-};
-struct Simple_Stack{
-    Cell * ptop;
-};
-Simple_Stack S;
-void ** location;
-int * collision;
+/******************************************************************************
+ * Elimination Backoff Stack
+ * Credit goes to Danny Hendler, Nir Shavit and Lena Yerushalmi - "A Scalable
+ * Lock-free Stack Algorithm"
+ *****************************************************************************/
+static thread_local unsigned elimSeed = 0;
 
-bool TryPerformStackOp(ThreadInfo * p)
+static int Elim_Random(int range)
 {
-    Cell * phead, *pnext;
-    if(p->op == 'H')
+    if (elimSeed == 0)
     {
-        phead = S.ptop;
-        p->cell.pnext = phead;
-        if (cell_CAS(&S.ptop, phead, &p->cell))
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
+        elimSeed = (unsigned)(uintptr_t)&elimSeed | 1;
     }
-    if (p->op == 'P')
+    elimSeed ^= elimSeed << 13;
+    elimSeed ^= elimSeed >> 17;
+    elimSeed ^= elimSeed << 5;
+    return elimSeed % range;
+}
+
+elimstack::elimstack(int collisionSlots) : ids(ELIM_MAX_THREADS)
+{
+    top.store(NULL);
+    collisionSize = (collisionSlots < 1) ? 1 : collisionSlots;
+    collision = new atomic<int>[collisionSize];
+    for (int pos = 0; pos < collisionSize; ++pos)
     {
-        phead = S.ptop;
-        if (phead == NULL)
-        {
-            p->cell = NULL;
-            return true;
-        }
-        pnext = phead->pnext;
-        if (e_CAS(&S.ptop, phead, pnext))
-        {
-            p->cell =  *phead;
-            return true;
-        }
-        else
-        {
-            p->cell = NULL;
-            return false;
-        }
+        collision[pos].store(ELIM_EMPTY);
+    }
+    for (int id = 0; id < ELIM_MAX_THREADS; ++id)
+    {
+        info[id].location.store(0);
+        info[id].cell.store(NULL);
+        info[id].seq = 0;
+        info[id].spin = ELIM_SPIN_MIN;
+        info[id].eliminated = 0;
+        info[id].operations = 0;
     }
 }
-void FinishCollision(ThreadInfo * p)
+
+elimstack::~elimstack()
 {
-    if (p->op == POP_OP)
+    node * t = top.load(memory_order_relaxed);
+    while (t != NULL)
     {
-        p->pcell = location[mypid]->pcell;
-        location[mypid] = NULL;
+        node * down = t->down;
+        delete t;
+        t = down;
     }
+    delete[] collision;
 }
-void TryCollision(ThreadInfo * p, ThreadInfo * q)
+
+int elimstack::MyId()
 {
-    if (p->op == 'H')
+    int id = ids.mine();
+    return (id < 0) ? ELIM_EMPTY : id;
+}
+
+/******************************************************************************
+ * @brief elimstack::push - Pushes val, eliminating against a pop if the CAS
+ *                          on top fails
+ * @param val - the value being pushed
+ * @return none
+ *****************************************************************************/
+void elimstack::push(int val)
+{
+    int mypid = MyId();
+    ThreadInfo local{};
+    ThreadInfo * p = (mypid == ELIM_EMPTY) ? &local : &info[mypid];
+    p->op = ELIM_PUSH;
+    p->cell.store(new node(val), memory_order_relaxed);
+    StackOp(p, mypid);
+}
+
+/******************************************************************************
+ * @brief elimstack::pop - Pops a value, eliminating against a push if the
+ *                         CAS on top fails
+ * @param None
+ * @return int - the value or -2 == EMPTY
+ *****************************************************************************/
+int elimstack::pop()
+{
+    int mypid = MyId();
+    ThreadInfo local{};
+    ThreadInfo * p = (mypid == ELIM_EMPTY) ? &local : &info[mypid];
+    p->op = ELIM_POP;
+    p->cell.store(NULL, memory_order_relaxed);
+    StackOp(p, mypid);
+    return p->val;
+}
+
+void elimstack::StackOp(ThreadInfo * p, int mypid)
+{
+    ++p->operations;
+    if (TryPerformStackOp(p))
     {
-        if (e_CAS(&location[him], q, p))
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
+        return;
     }
-    if (p->op == "P")
+    if (mypid == ELIM_EMPTY)
     {
-        if (e_CAS(&location[him], q, NULL))
+        backoff b(BACKOFF_EXP_e, ELIM_SPIN_MIN);
+        while (!TryPerformStackOp(p))
         {
-            p->cell = q->cell;
-            location[mypid] = NULL;
-            return true;
-        }
-        else
-        {
-            return false;
+            b.pause();
         }
+        return;
+    }
+    LesOP(p, mypid);
+}
+
+/******************************************************************************
+ * @brief elimstack::TryPerformStackOp - One Treiber attempt on top
+ * @param p - the operation
+ * @return true if it took effect (a pop of an empty stack counts)
+ *****************************************************************************/
+bool elimstack::TryPerformStackOp(ThreadInfo * p)
+{
+    if (p->op == ELIM_PUSH)
+    {
+        node * n = p->cell.load(memory_order_relaxed);
+        node * t = top.load(memory_order_acquire);
+        n->down = t;
+        return top.compare_exchange_strong(t, n, memory_order_acq_rel);
+    }
+    Reclaim_Enter();
+    node * t = Reclaim_Protect(0, top);
+    if (t == NULL)
+    {
+        Reclaim_Exit();
+        p->val = -2;
+        return true;
+    }
+    node * n = t->down;
+    int v = t->val;
+    if (!top.compare_exchange_strong(t, n, memory_order_acq_rel))
+    {
+        Reclaim_Exit();
+        return false;
+    }
+    Reclaim_Exit();
+    Reclaim_Retire(t);
+    p->val = v;
+    return true;
+}
+
+/******************************************************************************
+ * @brief elimstack::TryCollision - Active side of an elimination. A push
+ *                                  drops its node into the pop's location,
+ *                                  a pop takes the push's node by clearing
+ *                                  the push's location.
+ * @param p   - my operation
+ *        him - the partner's id
+ *        q   - the partner's location word as it was read
+ * @return true if the two operations eliminated each other
+ *****************************************************************************/
+bool elimstack::TryCollision(ThreadInfo * p, int him, uintptr_t q)
+{
+    if (p->op == ELIM_PUSH)
+    {
+        uintptr_t cell = (uintptr_t)p->cell.load(memory_order_relaxed);
+        return info[him].location.compare_exchange_strong(q, cell, memory_order_acq_rel);
+    }
+    // Read before the CAS: once it succeeds the pusher may start its next op
+    node * cell = info[him].cell.load(memory_order_acquire);
+    if (!info[him].location.compare_exchange_strong(q, 0, memory_order_acq_rel))
+    {
+        return false;
     }
+    p->val = cell->val;
+    delete cell;    // Never reached top, nobody else can be reading it
+    return true;
 }
 
-void LesOP(ThreadInfo * p)
+/******************************************************************************
+ * @brief elimstack::FinishCollision - Passive side. A pusher has nothing left
+ *                                     to do, a pop collects the node the
+ *                                     pusher left in its location.
+ * @param p - my operation
+ * @return none
+ *****************************************************************************/
+void elimstack::FinishCollision(ThreadInfo * p)
 {
-    while(true) {
-        location[mypid] = p;
-        int pos = GetPosition(p);
-        int him = collision[pos];
-        while(!e_CAS(&collision[pos], him, mypid))
+    if (p->op == ELIM_POP)
+    {
+        node * cell = (node *)p->location.load(memory_order_acquire);
+        p->location.store(0, memory_order_relaxed);
+        p->val = cell->val;
+        delete cell;
+    }
+}
+
+/******************************************************************************
+ * @brief elimstack::LesOP - Alternates between the collision array and the
+ *                           central stack until the operation completes
+ * @param p     - my operation
+ *        mypid - my id, the index of p in info
+ * @return none
+ *****************************************************************************/
+void elimstack::LesOP(ThreadInfo * p, int mypid)
+{
+    uintptr_t mine = ((++p->seq) << 2) | ((uintptr_t)p->op << 1) | 1;
+    while (true)
+    {
+        p->location.store(mine, memory_order_seq_cst);
+        int pos = Elim_Random(collisionSize);
+        int him = collision[pos].load(memory_order_relaxed);
+        while (!collision[pos].compare_exchange_weak(him, mypid, memory_order_acq_rel))
         {
-            him = collision[pos];
         }
-        if (him != )//Empty)
+        if (him != ELIM_EMPTY && him != mypid)
         {
-            int q = location[him];
-            if (q != NULL && q->id==him && q->op != p->op)
+            uintptr_t q = info[him].location.load(memory_order_acquire);
+            if ((q & 1) && (int)((q >> 1) & 1) != p->op)
             {
-                if (e_CAS(&location[mypid], p, NULL))
+                uintptr_t expected = mine;
+                if (p->location.compare_exchange_strong(expected, 0, memory_order_acq_rel))
                 {
-                    if(TryCollision(p, q) == true)
+                    if (TryCollision(p, him, q))
                     {
-                        break;
+                        ++p->eliminated;
+                        p->spin = (p->spin > ELIM_SPIN_MIN) ? p->spin / 2 : ELIM_SPIN_MIN;
+                        return;
                     }
-                    else
+                    if (TryPerformStackOp(p))
                     {
-                        if (TryPerformStackOp(p) == true)
-                        {
-                            break;
-                        }
+                        return;
                     }
+                    continue;
                 }
-                else {
-                    FinishCollision(p);
-                    return;
-                }
+                FinishCollision(p);
+                ++p->eliminated;
+                return;
             }
         }
-        // delay(p->spin);
-        if (e_CAS(!&location[mypid], p, NULL))
+        // The adaptive window seeds the wait, --backoff picks how it is spent
+        backoff window(BACKOFF_EXP_e, p->spin);
+        window.pause();
+        uintptr_t expected = mine;
+        if (!p->location.compare_exchange_strong(expected, 0, memory_order_acq_rel))
         {
             FinishCollision(p);
-            break;
+            ++p->eliminated;
+            return;
         }
-        if (TryPerformStackOp(p) == true)
+        if (TryPerformStackOp(p))
         {
-            break;
+            return;
         }
+        p->spin = (p->spin < ELIM_SPIN_MAX) ? p->spin * 2 : ELIM_SPIN_MAX;
     }
 }
 
-void StackOp(ThreadInfo * p) {
-    if (TryPerformStackOp(p) == false)
+/******************************************************************************
+ * @brief elimstack::report - Prints how many operations were eliminated.
+ *                            Only call this once the worker threads joined.
+ * @param none
+ * @return none
+ *****************************************************************************/
+void elimstack::report()
+{
+    unsigned long eliminated = 0;
+    unsigned long operations = 0;
+    for (int id = 0; id < ELIM_MAX_THREADS; ++id)
     {
-        LesOP(p);
+        eliminated += info[id].eliminated;
+        operations += info[id].operations;
     }
-}*/
\ No newline at end of file
+    printf("Eliminated: %lu of %lu operations\n", eliminated, operations);
+}
@@ -2,8 +2,13 @@
 #define ELiMINATIONSTACK_H
 
 #include <atomic>
+#include <stdint.h>
 #include "sgl.h"
 #include "treiberstack.h"
+#include "reclaim.h"
+#include "pool.h"
+#include "backoff.h"
+#include "threadids.h"
 
 using namespace std;
 
@@ -39,7 +44,7 @@ void elim_init(void);
 class estack
 {
 public:
-    class node 
+    class node : public pooled
     {
     public:
         node (int v):val(v){}
@@ -47,10 +52,72 @@ public:
         node * down;
     };
     atomic<node *> top;
+    estack();
+    ~estack();
     bool push(int val);
     int pop();
 };
 
+/******************************************************************************
+ * Elimination Backoff Stack (Hendler, Shavit and Yerushalmi, 2004)
+ * A Treiber stack whose failed CAS sends the thread to a collision array.
+ * Each thread advertises its pending operation in its ThreadInfo record and
+ * writes its id into a random collision slot; whoever it finds there with the
+ * opposite operation is paired with it and the push hands its node straight
+ * to the pop, neither touching top.
+ *
+ * location holds one word per thread: 0 when nothing is offered,
+ * (seq << 2) | (op << 1) | 1 while an operation is offered, or the address of
+ * a pushed node once a pusher collided with this (pop) thread.
+ *****************************************************************************/
+#define ELIM_MAX_THREADS 256    // Threads alive at once past this skip the collision array
+#define ELIM_EMPTY       -1     // Nobody in a collision slot
+#define ELIM_SPIN_MIN    32     // Window waiting for a partner, in pause loops
+#define ELIM_SPIN_MAX    4096
+#define ELIM_PUSH        0
+#define ELIM_POP         1
+
+class elimstack
+{
+public:
+    class node : public pooled
+    {
+    public:
+        node (int v):val(v), down(NULL){}
+        int val;
+        node * down;
+    };
+    struct alignas(64) ThreadInfo
+    {
+        atomic<uintptr_t> location;
+        atomic<node *> cell;    // The node a pending push offers
+        int op;
+        int val;                // What a pop ended up with
+        unsigned long seq;
+        int spin;
+        unsigned long eliminated;
+        unsigned long operations;
+    };
+    atomic<node *> top;
+    ThreadInfo info[ELIM_MAX_THREADS];
+    atomic<int> * collision;
+    int collisionSize;
+
+    elimstack(int collisionSlots);
+    ~elimstack();
+    void push(int val);
+    int pop();
+    void report();
+private:
+    threadids ids;
+    int MyId();
+    void StackOp(ThreadInfo * p, int mypid);
+    bool TryPerformStackOp(ThreadInfo * p);
+    bool TryCollision(ThreadInfo * p, int him, uintptr_t q);
+    void FinishCollision(ThreadInfo * p);
+    void LesOP(ThreadInfo * p, int mypid);
+};
+
 struct elimSGL
 {
 	sglStackStruct * sgl;
@@ -0,0 +1,200 @@
+#include "epoch.h"
+
+/******************************************************************************
+ * Epoch Based Reclamation
+ * Credit goes to Keir Fraser - "Practical Lock-Freedom", Chapter 5
+ *****************************************************************************/
+atomic<unsigned long> ebrGlobal (0);
+atomic<ebr_record *> ebrHead (NULL);
+
+/******************************************************************************
+ * Same life cycle as the hazard pointer records: a thread's record goes back
+ * to the list when it exits, its leftover retire list comes along with it.
+ *****************************************************************************/
+struct ebr_owner
+{
+    ebr_record * rec;
+    ebr_owner() : rec(NULL) {}
+    ~ebr_owner()
+    {
+        if (rec != NULL)
+        {
+            rec->epoch.store(0, memory_order_release);
+            EBR_Scan(rec);
+            rec->active.store(false, memory_order_release);
+        }
+    }
+};
+static thread_local ebr_owner ebrOwner;
+
+/******************************************************************************
+ * @brief EBR_Record - Returns the calling thread's record, adopting an
+ *                     inactive one or appending a new one on first use.
+ * @param none
+ * @return ebr_record * - the thread's record
+ *****************************************************************************/
+ebr_record * EBR_Record(void)
+{
+    if (ebrOwner.rec != NULL)
+    {
+        return ebrOwner.rec;
+    }
+    for (ebr_record * r = ebrHead.load(memory_order_acquire); r != NULL; r = r->next)
+    {
+        bool expected = false;
+        if (!r->active.load(memory_order_relaxed) &&
+            r->active.compare_exchange_strong(expected, true, memory_order_acq_rel))
+        {
+            ebrOwner.rec = r;
+            return r;
+        }
+    }
+    ebr_record * r = new ebr_record;
+    r->epoch.store(0, memory_order_relaxed);
+    r->scanAt = EBR_SCAN_THRESHOLD;
+    r->active.store(true, memory_order_relaxed);
+    r->retiredCount = 0;
+    r->reclaimedCount = 0;
+    ebr_record * h;
+    do
+    {
+        h = ebrHead.load(memory_order_acquire);
+        r->next = h;
+    } while (!ebrHead.compare_exchange_weak(h, r, memory_order_acq_rel));
+    ebrOwner.rec = r;
+    return r;
+}
+
+/******************************************************************************
+ * @brief EBR_Enter - Pins the current global epoch until EBR_Exit
+ * @param none
+ * @return none
+ *****************************************************************************/
+void EBR_Enter(void)
+{
+    ebr_record * rec = EBR_Record();
+    unsigned long e = ebrGlobal.load(memory_order_relaxed);
+    rec->epoch.store((e << 1) | EBR_ACTIVE, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);  // Pin before any shared read
+}
+
+/******************************************************************************
+ * @brief EBR_Exit - Marks the calling thread quiescent
+ * @param none
+ * @return none
+ *****************************************************************************/
+void EBR_Exit(void)
+{
+    EBR_Record()->epoch.store(0, memory_order_release);
+}
+
+/******************************************************************************
+ * @brief EBR_TryAdvance - Bumps the global epoch if every pinned thread has
+ *                         already observed it
+ * @param none
+ * @return the global epoch after the attempt
+ *****************************************************************************/
+static unsigned long EBR_TryAdvance(void)
+{
+    unsigned long e = ebrGlobal.load(memory_order_seq_cst);
+    for (ebr_record * r = ebrHead.load(memory_order_acquire); r != NULL; r = r->next)
+    {
+        unsigned long local = r->epoch.load(memory_order_seq_cst);
+        if ((local & EBR_ACTIVE) && (local >> 1) != e)
+        {
+            return e;
+        }
+    }
+    if (ebrGlobal.compare_exchange_strong(e, e + 1, memory_order_acq_rel))
+    {
+        return e + 1;
+    }
+    return e;   // Somebody else advanced it, e holds the new value
+}
+
+/******************************************************************************
+ * @brief EBR_Retire - Tags an unlinked node with the current epoch and frees
+ *                     it two epochs later. Advancing is only attempted once
+ *                     the retire list reaches scanAt.
+ * @param ptr     - the node, already unreachable from the container
+ *        deleter - how to free it
+ * @return none
+ *****************************************************************************/
+void EBR_Retire(void * ptr, void (* deleter)(void *))
+{
+    ebr_record * rec = EBR_Record();
+    ebr_retired r;
+    r.ptr = ptr;
+    r.deleter = deleter;
+    r.epoch = ebrGlobal.load(memory_order_acquire);
+    rec->retired.push_back(r);
+    ++rec->retiredCount;
+    if (rec->retired.size() >= rec->scanAt)
+    {
+        EBR_Scan(rec);
+    }
+}
+
+/******************************************************************************
+ * @brief EBR_Scan - Tries to advance the epoch, then frees everything on
+ *                   rec's list that is at least two epochs old
+ * @param rec - the record whose retire list is scanned
+ * @return none
+ *****************************************************************************/
+void EBR_Scan(ebr_record * rec)
+{
+    unsigned long e = EBR_TryAdvance();
+    size_t kept = 0;
+    for (size_t i = 0; i < rec->retired.size(); ++i)
+    {
+        if (rec->retired[i].epoch + 2 > e)
+        {
+            rec->retired[kept++] = rec->retired[i];
+        }
+        else
+        {
+            rec->retired[i].deleter(rec->retired[i].ptr);
+            ++rec->reclaimedCount;
+        }
+    }
+    rec->retired.resize(kept);
+    // A stalled thread can hold the epoch back for a long time. Waiting for
+    // the list to double keeps scans amortized O(1) per retire meanwhile.
+    rec->scanAt = (kept * 2 > EBR_SCAN_THRESHOLD) ? kept * 2 : EBR_SCAN_THRESHOLD;
+}
+
+/******************************************************************************
+ * @brief EBR_Flush - Frees everything still retired. Only call this once all
+ *                    worker threads are joined.
+ * @param none
+ * @return none
+ *****************************************************************************/
+void EBR_Flush(void)
+{
+    for (ebr_record * r = ebrHead.load(memory_order_acquire); r != NULL; r = r->next)
+    {
+        for (size_t i = 0; i < r->retired.size(); ++i)
+        {
+            r->retired[i].deleter(r->retired[i].ptr);
+            ++r->reclaimedCount;
+        }
+        r->retired.clear();
+    }
+}
+
+/******************************************************************************
+ * @brief EBR_Report - Prints how many nodes were retired and reclaimed
+ * @param none
+ * @return none
+ *****************************************************************************/
+void EBR_Report(void)
+{
+    unsigned long long retired = 0;
+    unsigned long long reclaimed = 0;
+    for (ebr_record * r = ebrHead.load(memory_order_acquire); r != NULL; r = r->next)
+    {
+        retired += r->retiredCount;
+        reclaimed += r->reclaimedCount;
+    }
+    printf("EBR retired: %llu reclaimed: %llu epoch: %lu\n", retired, reclaimed, ebrGlobal.load());
+}
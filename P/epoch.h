@@ -0,0 +1,48 @@
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#include <atomic>
+#include <vector>
+#include <stdio.h>
+
+using namespace std;
+
+#define EBR_SCAN_THRESHOLD 64   // Retires between attempts to advance the epoch
+#define EBR_ACTIVE         1UL  // Low bit of a record's epoch, set while pinned
+
+/******************************************************************************
+ * Epoch Based Reclamation (Keir Fraser, 2004)
+ * A thread pins the global epoch for the length of one container operation.
+ * The global epoch may only move on once every pinned thread has seen the
+ * current one, so a node retired in epoch e is unreachable by everybody once
+ * the global epoch reaches e + 2. Unlike hazard pointers, reads inside the
+ * operation are plain loads; the price is one store and fence per operation
+ * and a stalled thread holding back all frees.
+ *****************************************************************************/
+struct ebr_retired
+{
+    void * ptr;
+    void (* deleter)(void *);
+    unsigned long epoch;
+};
+
+struct ebr_record
+{
+    atomic<unsigned long> epoch;    // (epoch << 1) | EBR_ACTIVE, 0 when quiescent
+    atomic<bool> active;
+    ebr_record * next;
+    vector<ebr_retired> retired;
+    size_t scanAt;                  // Retire list length that triggers the next scan
+    unsigned long long retiredCount;
+    unsigned long long reclaimedCount;
+};
+
+ebr_record * EBR_Record(void);
+void EBR_Enter(void);
+void EBR_Exit(void);
+void EBR_Retire(void * ptr, void (* deleter)(void *));
+void EBR_Scan(ebr_record * rec);
+void EBR_Flush(void);
+void EBR_Report(void);
+
+#endif
@@ -0,0 +1,67 @@
+#include "eventcount.h"
+
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+/******************************************************************************
+ * Eventcount
+ * Credit goes to Dmitry Vyukov - "Eventcount", 1024cores.net
+ *****************************************************************************/
+eventcount::eventcount() : epoch(0), waiters(0), parks(0), wakes(0)
+{
+}
+
+/******************************************************************************
+ * @brief eventcount::prepare_wait - Registers the caller as a waiter. The
+ *                                   caller must re-check its container and
+ *                                   then either wait or cancel_wait.
+ * @param none
+ * @return unsigned - the key to wait on
+ *****************************************************************************/
+unsigned eventcount::prepare_wait()
+{
+    waiters.fetch_add(1, memory_order_seq_cst);
+    return epoch.load(memory_order_seq_cst);
+}
+
+void eventcount::cancel_wait()
+{
+    waiters.fetch_sub(1, memory_order_relaxed);
+}
+
+/******************************************************************************
+ * @brief eventcount::wait - Parks until a notify after prepare_wait, a
+ *                           timeout or a spurious wake up
+ * @param key     - from prepare_wait
+ *        timeout - relative, NULL for none
+ * @return bool - false if the timeout expired
+ *****************************************************************************/
+bool eventcount::wait(unsigned key, const struct timespec * timeout)
+{
+    ++parks;
+    long ret = syscall(SYS_futex, &epoch, FUTEX_WAIT_PRIVATE, key, timeout, NULL, 0);
+    waiters.fetch_sub(1, memory_order_relaxed);
+    return !(ret == -1 && errno == ETIMEDOUT);
+}
+
+/******************************************************************************
+ * @brief eventcount::Wake - Bumps the epoch so that waiters which have not
+ *                           parked yet will not, and wakes count of the ones
+ *                           that have
+ * @param count - waiters to wake
+ * @return none
+ *****************************************************************************/
+void eventcount::Wake(int count)
+{
+    epoch.fetch_add(1, memory_order_seq_cst);
+    syscall(SYS_futex, &epoch, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+    ++wakes;
+}
+
+void eventcount::report()
+{
+    printf("Parks: %lu wake calls: %lu\n", parks.load(), wakes.load());
+}
@@ -0,0 +1,103 @@
+#ifndef EVENTCOUNT_H
+#define EVENTCOUNT_H
+
+#include <atomic>
+#include <time.h>
+
+using namespace std;
+
+#define EC_SPINS 128    // Empty polls before a waiter parks
+
+/******************************************************************************
+ * Eventcount (Dmitry Vyukov) on a Linux futex
+ * Lets a consumer sleep on "the container is empty" without the producer
+ * paying a syscall per element. A waiter registers, re-checks the container
+ * and then parks on the epoch word. A producer publishes its element and
+ * then only looks at the waiter count, so while nobody waits notify is one
+ * fence and one load. The re-check after registering closes the gap: either
+ * the waiter sees the element or the producer sees the waiter, and the
+ * producer's epoch bump makes a park that races with it return at once.
+ *****************************************************************************/
+class eventcount
+{
+public:
+    eventcount();
+    unsigned prepare_wait();
+    void cancel_wait();
+    bool wait(unsigned key, const struct timespec * timeout);
+    inline void notify(int count = 1)
+    {
+        atomic_thread_fence(memory_order_seq_cst);  // Element visible before waiters is read
+        if (waiters.load(memory_order_relaxed) != 0)
+        {
+            Wake(count);
+        }
+    }
+    void report();
+private:
+    atomic<unsigned> epoch;     // The futex word
+    atomic<int> waiters;
+    atomic<unsigned long> parks;
+    atomic<unsigned long> wakes;
+    void Wake(int count);
+};
+
+/******************************************************************************
+ * @brief EC_Wait_For - Polls tryTake EC_SPINS times, then parks on ec until
+ *                      it hands back something or timeout runs out
+ * @param ec       - the container's eventcount
+ *        tryTake  - non-blocking take, -2 == EMPTY
+ *        timeout  - how long to wait in total, NULL to wait for ever
+ * @return int - what tryTake returned, -2 if the time ran out first
+ *****************************************************************************/
+template <class F>
+int EC_Wait_For(eventcount & ec, F tryTake, const struct timespec * timeout)
+{
+    int val;
+    for (int spins = 0; spins < EC_SPINS; ++spins)
+    {
+        val = tryTake();
+        if (val != -2)
+        {
+            return val;
+        }
+        __builtin_ia32_pause();
+    }
+    struct timespec now, deadline, left;
+    if (timeout != NULL)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += timeout->tv_sec;
+        deadline.tv_nsec += timeout->tv_nsec;
+        if (deadline.tv_nsec >= 1000000000)
+        {
+            deadline.tv_nsec -= 1000000000;
+            ++deadline.tv_sec;
+        }
+    }
+    while (true)
+    {
+        unsigned key = ec.prepare_wait();
+        val = tryTake();
+        if (val != -2)
+        {
+            ec.cancel_wait();
+            return val;
+        }
+        if (timeout != NULL)
+        {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            long long ns = (deadline.tv_sec - now.tv_sec) * 1000000000LL + (deadline.tv_nsec - now.tv_nsec);
+            if (ns <= 0)
+            {
+                ec.cancel_wait();
+                return -2;
+            }
+            left.tv_sec = ns / 1000000000;
+            left.tv_nsec = ns % 1000000000;
+        }
+        ec.wait(key, (timeout != NULL) ? &left : NULL);
+    }
+}
+
+#endif
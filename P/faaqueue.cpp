@@ -0,0 +1,167 @@
+#include "faaqueue.h"
+
+/******************************************************************************
+ * Fetch-and-Add Array Queue
+ * Credit goes to Pedro Ramalhete and Andreia Correia - "FAAArrayQueue",
+ * concurrencyfreaks.com
+ *****************************************************************************/
+/******************************************************************************
+ * @brief faaqueue::node::Create - Allocates a segment with its slots in line
+ * @param slots - how many slots
+ *        val   - put in the first slot, FAA_EMPTY for none
+ * @return node * - the segment, unlinked
+ *****************************************************************************/
+faaqueue::node * faaqueue::node::Create(int slots, int val)
+{
+    node * n = (node *)::operator new(sizeof(node) + (slots - 1) * sizeof(atomic<int>));
+    new (&n->deqidx) atomic<int>(0);
+    new (&n->enqidx) atomic<int>(val == FAA_EMPTY ? 0 : 1);
+    new (&n->next) atomic<node *>(NULL);
+    new (&n->items[0]) atomic<int>(val);
+    for (int i = 1; i < slots; ++i)
+    {
+        new (&n->items[i]) atomic<int>(FAA_EMPTY);
+    }
+    return n;
+}
+
+void faaqueue::node::Destroy(void * n)
+{
+    ::operator delete(n);
+}
+
+/******************************************************************************
+ * @brief faaqueue::faaqueue - Clamps segment to FAA_MIN_NODE..FAA_NODE_SIZE
+ *                             slots and allocates the first, empty, segment
+ *****************************************************************************/
+faaqueue::faaqueue(int segment)
+{
+    slots = (segment < FAA_MIN_NODE) ? FAA_MIN_NODE : (segment > FAA_NODE_SIZE) ? FAA_NODE_SIZE : segment;
+    segments.store(1);
+    node * sentinel = node::Create(slots, FAA_EMPTY);
+    head.store(sentinel);
+    tail.store(sentinel);
+}
+
+/******************************************************************************
+ * @brief faaqueue::~faaqueue - Frees the segments still linked. Segments
+ *                              the head moved past belong to the retire lists.
+ *****************************************************************************/
+faaqueue::~faaqueue()
+{
+    node * h = head.load();
+    while (h != NULL)
+    {
+        node * n = h->next.load();
+        node::Destroy(h);
+        h = n;
+    }
+}
+
+/******************************************************************************
+ * @brief faaqueue::enqueue - Takes a ticket in the tail segment, appending a
+ *                            new segment holding val once it is used up
+ * @param val - the value being enqueued
+ * @return none
+ *****************************************************************************/
+void faaqueue::enqueue(int val)
+{
+    backoff b;
+    Reclaim_Enter();
+    while (true)
+    {
+        node * t = Reclaim_Protect(0, tail);
+        int idx = t->enqidx.fetch_add(1);
+        if (idx > slots - 1)
+        {
+            // Segment used up, help or append
+            if (t != tail.load())
+            {
+                continue;
+            }
+            node * n = t->next.load();
+            if (n == NULL)
+            {
+                node * segment = node::Create(slots, val);
+                segments.fetch_add(1, memory_order_relaxed);
+                node * expected = NULL;
+                if (t->next.compare_exchange_strong(expected, segment))
+                {
+                    tail.compare_exchange_strong(t, segment);
+                    Reclaim_Exit();
+                    return;
+                }
+                node::Destroy(segment);
+            }
+            else
+            {
+                tail.compare_exchange_strong(t, n);
+            }
+            continue;
+        }
+        int empty = FAA_EMPTY;
+        if (t->items[idx].compare_exchange_strong(empty, val))
+        {
+            Reclaim_Exit();
+            return;
+        }
+        // A dequeuer gave up on this slot, take another ticket
+        b.pause();
+    }
+}
+
+/******************************************************************************
+ * @brief faaqueue::dequeue - Takes a ticket in the head segment, moving the
+ *                            head to the next segment once it is used up
+ * @param none
+ * @return int - the value, -2 if the queue is empty
+ *****************************************************************************/
+int faaqueue::dequeue()
+{
+    backoff b;
+    Reclaim_Enter();
+    while (true)
+    {
+        node * h = Reclaim_Protect(0, head);
+        if (h->deqidx.load() >= h->enqidx.load() && h->next.load() == NULL)
+        {
+            break;
+        }
+        int idx = h->deqidx.fetch_add(1);
+        if (idx > slots - 1)
+        {
+            node * n = h->next.load();
+            if (n == NULL)
+            {
+                break;
+            }
+            if (head.compare_exchange_strong(h, n))
+            {
+                Reclaim_Retire(h, node::Destroy);   // Still protected by slot 0 until we exit
+            }
+            continue;
+        }
+        int val = h->items[idx].exchange(FAA_TAKEN);
+        if (val == FAA_EMPTY)
+        {
+            b.pause();  // Got here before its enqueuer
+            continue;
+        }
+        Reclaim_Exit();
+        return val;
+    }
+    Reclaim_Exit();
+    return -2;
+}
+
+/******************************************************************************
+ * @brief faaqueue::report - Prints the segment size and how many segments
+ *                           were allocated, counting ones lost to a racing
+ *                           append
+ * @param none
+ * @return none
+ *****************************************************************************/
+void faaqueue::report()
+{
+    printf("FAA segment slots: %d segments allocated: %lu\n", slots, segments.load());
+}
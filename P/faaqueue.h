@@ -0,0 +1,60 @@
+#ifndef FAAQUEUE_H
+#define FAAQUEUE_H
+
+#include <atomic>
+#include <limits.h>
+#include <stdio.h>
+#include "reclaim.h"
+#include "ringqueue.h"  // CACHE_LINE
+#include "backoff.h"
+
+using namespace std;
+
+#define FAA_NODE_SIZE 1024          // Slots per segment, and the most --segment allows
+#define FAA_MIN_NODE  64            // Fewest slots --segment allows
+#define FAA_EMPTY     INT_MIN       // Slot not written yet
+#define FAA_TAKEN     (INT_MIN + 1) // Slot given up by a dequeuer
+
+/******************************************************************************
+ * Fetch-and-Add Array Queue (Ramalhete and Correia)
+ * A linked list of segments, each an array of FAA_NODE_SIZE slots. Enqueuers
+ * and dequeuers take a ticket from their segment's index with one
+ * fetch_add, so they do not retry a CAS on a shared pointer the way the MS
+ * queue does. The tail and head only move with a CAS once every
+ * FAA_NODE_SIZE operations, when a segment runs out. A dequeuer that gets
+ * to a slot before its enqueuer marks it taken, and that enqueuer then takes
+ * another ticket. FAA_EMPTY and FAA_TAKEN cannot be enqueued.
+ *
+ * The slots are allocated in line after the segment header, so the
+ * allocator is called once per segment rather than once per element as in
+ * the MS queue, and a dequeuer walks the slots in order.
+ *****************************************************************************/
+class faaqueue
+{
+public:
+    struct node
+    {
+        atomic<int> deqidx;
+        char pad0[CACHE_LINE - sizeof(atomic<int>)];
+        atomic<int> enqidx;
+        atomic<node *> next;
+        char pad1[CACHE_LINE - sizeof(atomic<int>) - sizeof(atomic<node *>)];
+        atomic<int> items[1];       // slots entries allocated in line
+        static node * Create(int slots, int val);
+        static void Destroy(void * n);
+    };
+    faaqueue(int segment = FAA_NODE_SIZE);
+    ~faaqueue();
+    void enqueue(int val);
+    int dequeue();
+    void report();
+private:
+    int slots;
+    atomic<unsigned long> segments;
+    atomic<node *> head;
+    char pad0[CACHE_LINE - sizeof(atomic<node *>)];
+    atomic<node *> tail;
+    char pad1[CACHE_LINE - sizeof(atomic<node *>)];
+};
+
+#endif
@@ -0,0 +1,231 @@
+#include "flatcombining.h"
+
+#include <new>       // bad_alloc, placement new
+#include <stdlib.h>  // posix_memalign
+
+/******************************************************************************
+ * Flat Combining
+ * Credit goes to Danny Hendler, Itai Incze, Nir Shavit and Moran Tzafrir -
+ * "Flat Combining and the Synchronization-Parallelism Tradeoff"
+ *****************************************************************************/
+atomic<unsigned> fcGeneration (0);
+
+/******************************************************************************
+ * A thread caches its record for the last combiner it used. The generation
+ * tells a new object at a recycled address apart from the old one. Records
+ * are tagged with the address of the owner's fcToken, which no two live
+ * threads share, so a thread coming back to a combiner finds its record
+ * there again. A thread that gets a dead thread's token address adopts its
+ * record, which has nothing pending.
+ *****************************************************************************/
+struct fc_owner
+{
+    unsigned generation;
+    flatcombiner::record * rec;
+};
+static thread_local fc_owner fcOwner = {0, NULL};
+static thread_local char fcToken;
+
+flatcombiner::flatcombiner()
+{
+    locked.store(false);
+    publication.store(NULL);
+    rounds = 0;
+    combined = 0;
+    records.store(0);
+    generation = ++fcGeneration;
+}
+
+flatcombiner::~flatcombiner()
+{
+    record * r = publication.load();
+    while (r != NULL)
+    {
+        record * next = r->next;
+        r->~record();
+        free(r);
+        r = next;
+    }
+}
+
+/******************************************************************************
+ * @brief flatcombiner::MyRecord - Returns the calling thread's record,
+ *                                 enlisting a new one on first use
+ * @param none
+ * @return record * - the thread's publication record
+ *****************************************************************************/
+flatcombiner::record * flatcombiner::MyRecord()
+{
+    if (fcOwner.generation == generation)
+    {
+        return fcOwner.rec;
+    }
+    fcOwner.generation = generation;
+    for (record * r = publication.load(memory_order_acquire); r != NULL; r = r->next)
+    {
+        if (r->owner == &fcToken)
+        {
+            fcOwner.rec = r;
+            return r;
+        }
+    }
+    // new only promises 16 bytes under C++11, each record needs a line
+    void * raw = NULL;
+    if (posix_memalign(&raw, alignof(record), sizeof(record)) != 0)
+    {
+        throw bad_alloc();
+    }
+    record * r = new (raw) record;
+    r->request.store(FC_NONE, memory_order_relaxed);
+    r->value = 0;
+    r->result = 0;
+    r->owner = &fcToken;
+    record * h;
+    do
+    {
+        h = publication.load(memory_order_acquire);
+        r->next = h;
+    } while (!publication.compare_exchange_weak(h, r, memory_order_acq_rel));
+    records.fetch_add(1, memory_order_relaxed);
+    fcOwner.rec = r;
+    return r;
+}
+
+/******************************************************************************
+ * @brief flatcombiner::Combine - Serves every pending request on the
+ *                                publication list. Lock must be held.
+ * @param none
+ * @return none
+ *****************************************************************************/
+void flatcombiner::Combine()
+{
+    ++rounds;
+    for (int pass = 0; pass < FC_PASSES; ++pass)
+    {
+        for (record * r = publication.load(memory_order_acquire); r != NULL; r = r->next)
+        {
+            int op = r->request.load(memory_order_acquire);
+            if (op != FC_NONE)
+            {
+                r->result = Apply(op, r->value);
+                r->request.store(FC_NONE, memory_order_release);
+                ++combined;
+            }
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief flatcombiner::Execute - Publishes a request and waits until it has
+ *                                been served, combining if the lock is free
+ * @param op    - FC_PUSH or FC_POP
+ *        value - the item for FC_PUSH
+ * @return the result Apply gave the request
+ *****************************************************************************/
+int flatcombiner::Execute(int op, int value)
+{
+    record * r = MyRecord();
+    r->value = value;
+    r->request.store(op, memory_order_release);
+    backoff b(BACKOFF_EXP_e);   // Ends up yielding, the combiner may be waiting for our core
+    while (true)
+    {
+        if (!locked.load(memory_order_relaxed) &&
+            !locked.exchange(true, memory_order_acquire))
+        {
+            Combine();
+            locked.store(false, memory_order_release);
+        }
+        if (r->request.load(memory_order_acquire) == FC_NONE)
+        {
+            return r->result;
+        }
+        b.pause();
+    }
+}
+
+/******************************************************************************
+ * @brief flatcombiner::report - Prints how many requests each combining
+ *                               round served on average and how many
+ *                               records are enlisted
+ * @param none
+ * @return none
+ *****************************************************************************/
+void flatcombiner::report()
+{
+    printf("Combined: %lu requests in %lu rounds (%.2f per round) records: %lu\n", combined, rounds,
+           rounds ? (double)combined / rounds : 0.0, records.load());
+}
+
+unsigned long flatcombiner::enlisted()
+{
+    return records.load();
+}
+
+/******************************************************************************
+ * FC Stack
+ *****************************************************************************/
+void fcstack::push(int val)
+{
+    Execute(FC_PUSH, val);
+}
+
+/******************************************************************************
+ * @brief fcstack::pop - Pops through the combiner
+ * @param None
+ * @return int - the value or -2 == EMPTY
+ *****************************************************************************/
+int fcstack::pop()
+{
+    return Execute(FC_POP, 0);
+}
+
+int fcstack::Apply(int op, int value)
+{
+    if (op == FC_PUSH)
+    {
+        lifoStack.push(value);
+        return 0;
+    }
+    if (lifoStack.empty())
+    {
+        return -2;
+    }
+    int v = lifoStack.top();
+    lifoStack.pop();
+    return v;
+}
+
+/******************************************************************************
+ * FC Queue
+ *****************************************************************************/
+void fcqueue::enqueue(int val)
+{
+    Execute(FC_PUSH, val);
+}
+
+/******************************************************************************
+ * @brief fcqueue::dequeue - Dequeues through the combiner
+ * @param None
+ * @return int - the value or -2 == EMPTY
+ *****************************************************************************/
+int fcqueue::dequeue()
+{
+    return Execute(FC_POP, 0);
+}
+
+int fcqueue::Apply(int op, int value)
+{
+    if (op == FC_PUSH)
+    {
+        fifoQueue.push(value);
+        return 0;
+    }
+    if (fifoQueue.empty())
+    {
+        return -2;
+    }
+    int v = fifoQueue.front();
+    fifoQueue.pop();
+    return v;
+}
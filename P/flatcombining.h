@@ -0,0 +1,74 @@
+#ifndef FLATCOMBINING_H
+#define FLATCOMBINING_H
+
+#include <atomic>
+#include <stack>
+#include <queue>
+#include <stdio.h>
+#include "backoff.h"
+
+using namespace std;
+
+#define FC_NONE   0     // No request pending, or the last one was served
+#define FC_PUSH   1     // Push for the stack, enqueue for the queue
+#define FC_POP    2     // Pop for the stack, dequeue for the queue
+#define FC_PASSES 2     // Scans of the publication list per combining round
+
+/******************************************************************************
+ * Flat Combining (Hendler, Incze, Shavit and Tzafrir, 2010)
+ * Instead of every thread taking the lock for its own element, a thread
+ * publishes its request in its record on the publication list and spins on
+ * it. Whoever grabs the lock becomes the combiner and serves every pending
+ * request in the list in one pass, so the lock and the sequential structure
+ * stay in the combiner's cache instead of bouncing once per element.
+ *****************************************************************************/
+class flatcombiner
+{
+public:
+    struct alignas(64) record
+    {
+        atomic<int> request;
+        int value;
+        int result;
+        record * next;
+        const void * owner;     // The enlisting thread's fcToken
+    };
+    flatcombiner();
+    virtual ~flatcombiner();
+    void report();
+    unsigned long enlisted();   // Records on the publication list
+protected:
+    int Execute(int op, int value);
+    virtual int Apply(int op, int value) = 0;   // Called with the lock held
+private:
+    atomic<bool> locked;
+    atomic<record *> publication;
+    unsigned generation;
+    unsigned long rounds;       // Only touched by the combiner
+    unsigned long combined;
+    atomic<unsigned long> records;
+    record * MyRecord();
+    void Combine();
+};
+
+class fcstack : public flatcombiner
+{
+public:
+    std::stack<int> lifoStack;
+    void push(int val);
+    int pop();
+protected:
+    int Apply(int op, int value);
+};
+
+class fcqueue : public flatcombiner
+{
+public:
+    std::queue<int> fifoQueue;
+    void enqueue(int val);
+    int dequeue();
+protected:
+    int Apply(int op, int value);
+};
+
+#endif
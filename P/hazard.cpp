@@ -0,0 +1,199 @@
+#include "hazard.h"
+
+#include <algorithm>
+
+/******************************************************************************
+ * Hazard Pointers
+ * Credit goes to Maged Michael - "Hazard Pointers: Safe Memory Reclamation
+ * for Lock-Free Objects"
+ *****************************************************************************/
+atomic<hp_record *> hpHead (NULL);
+atomic<int> hpRecords (0);
+
+/******************************************************************************
+ * The owner gives the record back when its thread exits so the slot array
+ * stays as long as the peak number of live threads, not the total ever run.
+ *****************************************************************************/
+struct hp_owner
+{
+    hp_record * rec;
+    hp_owner() : rec(NULL) {}
+    ~hp_owner()
+    {
+        if (rec != NULL)
+        {
+            HP_Clear();
+            HP_Scan(rec);
+            rec->active.store(false, memory_order_release);
+        }
+    }
+};
+static thread_local hp_owner hpOwner;
+
+/******************************************************************************
+ * @brief HP_Record - Returns the calling thread's record, adopting an
+ *                    inactive one or appending a new one on first use.
+ * @param none
+ * @return hp_record * - the thread's record
+ *****************************************************************************/
+hp_record * HP_Record(void)
+{
+    if (hpOwner.rec != NULL)
+    {
+        return hpOwner.rec;
+    }
+    for (hp_record * r = hpHead.load(memory_order_acquire); r != NULL; r = r->next)
+    {
+        bool expected = false;
+        if (!r->active.load(memory_order_relaxed) &&
+            r->active.compare_exchange_strong(expected, true, memory_order_acq_rel))
+        {
+            hpOwner.rec = r;
+            return r;
+        }
+    }
+    hp_record * r = new hp_record;
+    for (int slot = 0; slot < HP_PER_THREAD; ++slot)
+    {
+        r->hazard[slot].store(NULL, memory_order_relaxed);
+    }
+    r->active.store(true, memory_order_relaxed);
+    r->retiredCount = 0;
+    r->reclaimedCount = 0;
+    hp_record * h;
+    do
+    {
+        h = hpHead.load(memory_order_acquire);
+        r->next = h;
+    } while (!hpHead.compare_exchange_weak(h, r, memory_order_acq_rel));
+    ++hpRecords;
+    hpOwner.rec = r;
+    return r;
+}
+
+/******************************************************************************
+ * @brief HP_Publish - Publishes ptr in a hazard slot. The caller must then
+ *                     re-read whatever it got ptr from to validate it, for
+ *                     sources HP_Protect cannot load (packed words).
+ * @param slot - which of the thread's hazard slots to use
+ *        ptr  - the node about to be dereferenced
+ * @return none
+ *****************************************************************************/
+void HP_Publish(int slot, void * ptr)
+{
+    HP_Record()->hazard[slot].store(ptr, memory_order_seq_cst);
+}
+
+/******************************************************************************
+ * @brief HP_Clear - Drops every hazard the calling thread holds
+ * @param none
+ * @return none
+ *****************************************************************************/
+void HP_Clear(void)
+{
+    hp_record * rec = HP_Record();
+    for (int slot = 0; slot < HP_PER_THREAD; ++slot)
+    {
+        rec->hazard[slot].store(NULL, memory_order_release);
+    }
+}
+
+/******************************************************************************
+ * @brief HP_Retire - Hands an unlinked node over for deferred freeing. Scans
+ *                    are batched so the cost of reading every hazard slot is
+ *                    spread across HP_SCAN_THRESHOLD retires.
+ * @param ptr     - the node, already unreachable from the container
+ *        deleter - how to free it once no hazard covers it
+ * @return none
+ *****************************************************************************/
+void HP_Retire(void * ptr, void (* deleter)(void *))
+{
+    hp_record * rec = HP_Record();
+    hp_retired r;
+    r.ptr = ptr;
+    r.deleter = deleter;
+    rec->retired.push_back(r);
+    ++rec->retiredCount;
+    if (rec->retired.size() >= (size_t)(HP_SCAN_THRESHOLD + 2 * HP_PER_THREAD * hpRecords.load(memory_order_relaxed)))
+    {
+        HP_Scan(rec);
+    }
+}
+
+/******************************************************************************
+ * @brief HP_Scan - Frees every node on rec's retire list that is not
+ *                  currently published in any hazard slot
+ * @param rec - the record whose retire list is scanned
+ * @return none
+ *****************************************************************************/
+void HP_Scan(hp_record * rec)
+{
+    vector<void *> hazards;
+    for (hp_record * r = hpHead.load(memory_order_acquire); r != NULL; r = r->next)
+    {
+        for (int slot = 0; slot < HP_PER_THREAD; ++slot)
+        {
+            void * p = r->hazard[slot].load(memory_order_seq_cst);
+            if (p != NULL)
+            {
+                hazards.push_back(p);
+            }
+        }
+    }
+    sort(hazards.begin(), hazards.end());
+
+    size_t kept = 0;
+    for (size_t i = 0; i < rec->retired.size(); ++i)
+    {
+        if (binary_search(hazards.begin(), hazards.end(), rec->retired[i].ptr))
+        {
+            rec->retired[kept++] = rec->retired[i];
+        }
+        else
+        {
+            rec->retired[i].deleter(rec->retired[i].ptr);
+            ++rec->reclaimedCount;
+        }
+    }
+    rec->retired.resize(kept);
+}
+
+/******************************************************************************
+ * @brief HP_Flush - Frees everything still retired. Only call this once all
+ *                   worker threads are joined, nothing can be protected then.
+ * @param none
+ * @return none
+ *****************************************************************************/
+void HP_Flush(void)
+{
+    for (hp_record * r = hpHead.load(memory_order_acquire); r != NULL; r = r->next)
+    {
+        for (int slot = 0; slot < HP_PER_THREAD; ++slot)
+        {
+            r->hazard[slot].store(NULL, memory_order_relaxed);
+        }
+        for (size_t i = 0; i < r->retired.size(); ++i)
+        {
+            r->retired[i].deleter(r->retired[i].ptr);
+            ++r->reclaimedCount;
+        }
+        r->retired.clear();
+    }
+}
+
+/******************************************************************************
+ * @brief HP_Report - Prints how many nodes were retired and reclaimed
+ * @param none
+ * @return none
+ *****************************************************************************/
+void HP_Report(void)
+{
+    unsigned long long retired = 0;
+    unsigned long long reclaimed = 0;
+    for (hp_record * r = hpHead.load(memory_order_acquire); r != NULL; r = r->next)
+    {
+        retired += r->retiredCount;
+        reclaimed += r->reclaimedCount;
+    }
+    printf("HP retired: %llu reclaimed: %llu records: %d\n", retired, reclaimed, hpRecords.load());
+}
@@ -0,0 +1,83 @@
+#ifndef HAZARD_H
+#define HAZARD_H
+
+#include <atomic>
+#include <vector>
+#include <stdio.h>
+
+using namespace std;
+
+#define HP_PER_THREAD     3     // Hazard slots each thread may hold at once
+#define HP_SCAN_THRESHOLD 64    // Retired nodes kept before a scan is forced
+
+/******************************************************************************
+ * Hazard Pointers (Maged Michael, 2004)
+ * Every thread owns a record of HP_PER_THREAD hazard slots. Before a thread
+ * dereferences a shared node it publishes the pointer in one of its slots and
+ * re-reads the source to make sure the node was still reachable. Unlinked
+ * nodes are put on the thread's retire list and only freed by a scan once no
+ * slot in any record points at them. Records are never unlinked, a thread
+ * that exits just marks its record inactive for the next thread to adopt.
+ *****************************************************************************/
+struct hp_retired
+{
+    void * ptr;
+    void (* deleter)(void *);
+};
+
+struct hp_record
+{
+    atomic<void *> hazard[HP_PER_THREAD];
+    atomic<bool> active;
+    hp_record * next;
+    vector<hp_retired> retired;
+    unsigned long long retiredCount;    // Owned by the thread holding the record
+    unsigned long long reclaimedCount;
+};
+
+hp_record * HP_Record(void);
+void HP_Publish(int slot, void * ptr);
+void HP_Clear(void);
+void HP_Retire(void * ptr, void (* deleter)(void *));
+void HP_Scan(hp_record * rec);
+void HP_Flush(void);
+void HP_Report(void);
+
+/******************************************************************************
+ * @brief HP_Protect - Publishes the node currently in src in a hazard slot
+ *                     and retries until the publication is known to have
+ *                     happened before anybody could retire that node.
+ * @param slot - which of the thread's hazard slots to use
+ *        src  - the shared pointer about to be dereferenced
+ * @return the protected pointer (may be NULL)
+ *****************************************************************************/
+template <class T>
+T * HP_Protect(int slot, atomic<T *> & src)
+{
+    hp_record * rec = HP_Record();
+    T * p = src.load(memory_order_acquire);
+    while (true)
+    {
+        rec->hazard[slot].store(p, memory_order_seq_cst);
+        T * again = src.load(memory_order_seq_cst);
+        if (again == p)
+        {
+            return p;
+        }
+        p = again;
+    }
+}
+
+template <class T>
+void HP_Delete(void * ptr)
+{
+    delete (T *)ptr;
+}
+
+template <class T>
+void HP_Retire(T * ptr)
+{
+    HP_Retire((void *)ptr, HP_Delete<T>);
+}
+
+#endif
@@ -0,0 +1,178 @@
+#include "intrusive.h"
+
+/******************************************************************************
+ * Intrusive Treiber Stack
+ *****************************************************************************/
+static inline ihook * ITS_Hook(uint64_t word)
+{
+    return (ihook *)(uintptr_t)(word & ITS_PTR_MASK);
+}
+
+static inline uint64_t ITS_Word(ihook * h, uint64_t old)
+{
+    uint16_t tag = (uint16_t)(old >> ITS_TAG_SHIFT) + 1;
+    return ((uint64_t)(uintptr_t)h & ITS_PTR_MASK) | ((uint64_t)tag << ITS_TAG_SHIFT);
+}
+
+itstack::itstack()
+{
+    top.store(0);
+}
+
+/******************************************************************************
+ * @brief itstack::push - Links h in as the new top
+ * @param h - the caller's hook, not in any container
+ * @return none
+ *****************************************************************************/
+void itstack::push(ihook * h)
+{
+    backoff b;
+    uint64_t t = top.load(memory_order_relaxed);
+    while (true)
+    {
+        h->next.store(ITS_Hook(t), memory_order_relaxed);
+        if (top.compare_exchange_weak(t, ITS_Word(h, t), memory_order_release, memory_order_relaxed))
+        {
+            return;
+        }
+        b.pause();
+    }
+}
+
+/******************************************************************************
+ * @brief itstack::pop - Unlinks the top hook
+ * @param none
+ * @return ihook * - the hook, the caller's again, or NULL if empty
+ *****************************************************************************/
+ihook * itstack::pop()
+{
+    backoff b;
+    uint64_t t = top.load(memory_order_acquire);
+    while (true)
+    {
+        ihook * h = ITS_Hook(t);
+        if (h == NULL)
+        {
+            return NULL;
+        }
+        // h may be popped and reused meanwhile, the tag then fails the CAS
+        ihook * n = h->next.load(memory_order_relaxed);
+        if (top.compare_exchange_weak(t, ITS_Word(n, t), memory_order_acquire, memory_order_acquire))
+        {
+            return h;
+        }
+        b.pause();
+    }
+}
+
+/******************************************************************************
+ * Intrusive Michael and Scott Queue
+ * Same algorithm as msqueue with hazard slots 0 (head or tail) and 1 (next)
+ *****************************************************************************/
+imsqueue::imsqueue(void (* releaseHook)(void *)) : release(releaseHook)
+{
+    head.store(&stub);
+    tail.store(&stub);
+}
+
+/******************************************************************************
+ * @brief imsqueue::~imsqueue - Gives the final dummy back to release. No
+ *                              dequeue can move past it now, so it never
+ *                              reaches the retire list.
+ *****************************************************************************/
+imsqueue::~imsqueue()
+{
+    ihook * h = head.load(memory_order_acquire);
+    if (h != &stub)
+    {
+        release(h);
+    }
+}
+
+/******************************************************************************
+ * @brief imsqueue::enqueue - Links h in after the tail
+ * @param h - the caller's hook, not in any container
+ * @return none
+ *****************************************************************************/
+void imsqueue::enqueue(ihook * h)
+{
+    ihook * t;
+    ihook * e;
+    backoff b;
+    h->next.store(NULL, memory_order_relaxed);
+    Reclaim_Enter();
+    while (true)
+    {
+        t = Reclaim_Protect(0, tail);
+        e = t->next.load(memory_order_acquire);
+        if (t == tail.load(memory_order_acquire))
+        {
+            ihook * expected = NULL;
+            if (e == NULL && t->next.compare_exchange_weak(expected, h, memory_order_release, memory_order_relaxed))
+            {
+                break;
+            }
+            if (e != NULL)
+            {
+                tail.compare_exchange_weak(t, e, memory_order_release, memory_order_relaxed);
+            }
+        }
+        b.pause();
+    }
+    tail.compare_exchange_weak(t, h, memory_order_release, memory_order_relaxed);
+    Reclaim_Exit();
+}
+
+/******************************************************************************
+ * @brief imsqueue::dequeue - Unlinks the oldest hook. The old dummy goes to
+ *                            the retire list, the returned hook becomes the
+ *                            dummy and stays protected until done().
+ * @param none
+ * @return ihook * - the hook holding the value, or NULL if empty
+ *****************************************************************************/
+ihook * imsqueue::dequeue()
+{
+    ihook * h;
+    ihook * t;
+    ihook * n;
+    backoff b;
+    Reclaim_Enter();
+    while (true)
+    {
+        h = Reclaim_Protect(0, head);
+        t = tail.load(memory_order_acquire);
+        n = Reclaim_Protect(1, h->next);
+        if (h != head.load(memory_order_acquire))
+        {
+            continue;
+        }
+        if (h == t)
+        {
+            if (n == NULL)
+            {
+                Reclaim_Exit();
+                return NULL;
+            }
+            tail.compare_exchange_weak(t, n, memory_order_release, memory_order_relaxed);
+        }
+        else if (head.compare_exchange_weak(h, n, memory_order_acq_rel, memory_order_relaxed))
+        {
+            if (h != &stub)
+            {
+                Reclaim_Retire(h, release);
+            }
+            return n;   // Still in slot 1
+        }
+        b.pause();
+    }
+}
+
+/******************************************************************************
+ * @brief imsqueue::done - Drops the protection of the last dequeued hook
+ * @param none
+ * @return none
+ *****************************************************************************/
+void imsqueue::done()
+{
+    Reclaim_Exit();
+}
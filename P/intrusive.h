@@ -0,0 +1,74 @@
+#ifndef INTRUSIVE_H
+#define INTRUSIVE_H
+
+#include <atomic>
+#include <stdint.h>
+#include "reclaim.h"
+#include "ringqueue.h"  // CACHE_LINE
+#include "backoff.h"
+
+using namespace std;
+
+#define ITS_PTR_MASK  0x0000FFFFFFFFFFFFULL    // User space pointer
+#define ITS_TAG_SHIFT 48                       // Tag lives in the unused top bits
+
+/******************************************************************************
+ * Intrusive hook - embedded in the caller's own struct, so linking it into a
+ * container needs no allocation of its own and the payload sits on the same
+ * cache lines as the link.
+ *****************************************************************************/
+struct ihook
+{
+    atomic<ihook *> next;
+    ihook() : next(NULL) {}
+};
+
+/******************************************************************************
+ * Intrusive Treiber Stack
+ * push and pop only relink hooks. A popped hook belongs to the caller again
+ * straight away and may be pushed back at once, so the top carries a 16 bit
+ * tag, bumped by every successful CAS, in place of reclamation to stop ABA.
+ * A popper may still read the next field of a hook it lost the race for, so
+ * hooks must stay allocated (pooled, not freed) while the stack is in use.
+ *****************************************************************************/
+class itstack
+{
+public:
+    itstack();
+    void push(ihook * h);
+    ihook * pop();
+private:
+    atomic<uint64_t> top;   // Hook pointer | tag << ITS_TAG_SHIFT
+    char pad0[CACHE_LINE - sizeof(atomic<uint64_t>)];
+};
+
+/******************************************************************************
+ * Intrusive Michael and Scott Queue
+ * The queue starts on a dummy of its own, after that the last dequeued hook
+ * is the dummy. dequeue hands back the hook holding the value, which stays
+ * protected until the caller's done() (or its next container operation);
+ * the caller reads it but must not reuse it. Once a later dequeue has moved
+ * past it and no thread protects it any more, the reclamation scheme hands
+ * it to release, and from then on it is the caller's again. The last
+ * dequeued hook is only moved past by a later dequeue, so the destructor
+ * hands the final dummy to release itself; hooks still enqueued were never
+ * dequeued and stay the caller's. No thread may be using the queue then.
+ *****************************************************************************/
+class imsqueue
+{
+public:
+    imsqueue(void (* releaseHook)(void *));
+    ~imsqueue();
+    void enqueue(ihook * h);
+    ihook * dequeue();
+    void done();
+private:
+    atomic<ihook *> head;
+    char pad0[CACHE_LINE - sizeof(atomic<ihook *>)];
+    atomic<ihook *> tail;
+    char pad1[CACHE_LINE - sizeof(atomic<ihook *>)];
+    ihook stub;
+    void (* release)(void *);
+};
+
+#endif
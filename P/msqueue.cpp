@@ -4,38 +4,69 @@
  * M&S Queue
  * Credit goes to Joe Izraelevitz - Concurrent Programming Class Lecture Notes
  *****************************************************************************/ 
-msqueue::msqueue() 
+template <class P>
+basic_msqueue<P>::basic_msqueue() 
 {
     node * dummy = new node(DUMMY);
     dummy->next = NULL;
     head.store(dummy);
     tail.store(dummy);
+    maxEnqRetries.store(0);
+    maxDeqRetries.store(0);
 }
 
-void msqueue::print()
+/******************************************************************************
+ * @brief msqueue::~msqueue - Frees the dummy and anything not dequeued.
+ *                            Dequeued dummies belong to the retire lists.
+ *****************************************************************************/ 
+template <class P>
+basic_msqueue<P>::~basic_msqueue()
+{
+    node * h = head.load(P::load);
+    while (h != NULL)
+    {
+        node * n = h->next.load(P::load);
+        delete h;
+        h = n;
+    }
+}
+
+template <class P>
+void basic_msqueue<P>::print()
 {
-    node * h = head.load(); 
-    node * t = tail.load(); 
+    node * h = head.load(P::load); 
+    node * t = tail.load(P::load); 
     while (h != t) 
     {
-        h = h->next.load();
+        h = h->next.load(P::load);
         printf("%d ", h->val);
     }
     printf("\n");
 }
 
-void msqueue::enqueue(int val) 
+template <class P>
+void basic_msqueue<P>::report()
+{
+    printf("Max retries: enqueue %lu dequeue %lu\n", maxEnqRetries.load(), maxDeqRetries.load());
+}
+
+template <class P>
+void basic_msqueue<P>::enqueue(int val) 
 {
     node * t, * e, * n;
     node * dummy = NULL;
+    unsigned long attempts = 0;
+    backoff b;
     n = new node(val);
+    Reclaim_Enter();
     while(true) 
     {
-        t = tail.load();
-        e = t->next.load();
-        if (t == tail.load())
+        ++attempts;
+        t = Reclaim_Protect(0, tail);
+        e = t->next.load(P::load);
+        if (t == tail.load(P::load))
         {
-            if (e == NULL && t->next.compare_exchange_weak(dummy,n)) 
+            if (e == NULL && t->next.compare_exchange_weak(dummy, n, P::cas, P::casFail)) 
             {
                 // printf("MS-EN:%d\n", val);
                 break;
@@ -43,39 +74,254 @@ void msqueue::enqueue(int val)
         }
         else 
         {
-            tail.compare_exchange_weak(t,e);
+            tail.compare_exchange_weak(t, e, P::cas, P::casFail);
         }
+        b.pause();
     }
-    tail.compare_exchange_weak(t,n);
+    tail.compare_exchange_weak(t, n, P::cas, P::casFail);
+    Reclaim_Exit();
+    Retry_Max(maxEnqRetries, attempts - 1);
+    ready.notify();
 }
 
-int msqueue::dequeue() 
+template <class P>
+int basic_msqueue<P>::dequeue() 
 {
     node *t, *h, *n;
+    unsigned long attempts = 0;
+    backoff b;
+    Reclaim_Enter();
     while(true){
-        h = head.load(); 
-        t = tail.load(); 
-        n = h->next.load();
+        ++attempts;
+        h = Reclaim_Protect(0, head);
+        t = tail.load(P::load); 
+        n = Reclaim_Protect(1, h->next);
+        if (h != head.load(P::load))
+        {
+            continue;   // h was dequeued, n may already be retired
+        }
         if (h == t) 
         {
             if (n == NULL)
             {
+                Reclaim_Exit();
+                Retry_Max(maxDeqRetries, attempts - 1);
                 return -2; // Should be null
             }
             else
             {
-                tail.compare_exchange_weak(t,n);
+                tail.compare_exchange_weak(t, n, P::cas, P::casFail);
             }
         }
         else
         {
             int ret = n->val;
-            if (head.compare_exchange_weak(h,n))
+            if (head.compare_exchange_weak(h, n, P::cas, P::casFail))
             {
+                Reclaim_Exit();
+                Reclaim_Retire(h);   // n is the new dummy
+                Retry_Max(maxDeqRetries, attempts - 1);
             	// printf("MS-DE:%d\n", ret);
                 return ret;
             }
         }
+        b.pause();
+    }
+}
+
+
+/******************************************************************************
+ * @brief msqueue::dequeue_wait - Like dequeue, but an empty queue is waited
+ *                                on: a short spin, then a futex park until
+ *                                an enqueue wakes it
+ * @param timeout - how long to wait, NULL to wait for ever
+ * @return int - the value or -2 if nothing arrived in time
+ *****************************************************************************/
+template <class P>
+int basic_msqueue<P>::dequeue_wait(const struct timespec * timeout)
+{
+    return EC_Wait_For(ready, [this]() { return dequeue(); }, timeout);
+}
+
+/******************************************************************************
+ * @brief msqueue::enqueue_batch - Links the values into a private chain and
+ *                                 appends all of it with one CAS on
+ *                                 tail->next, then swings tail to its end
+ * @param vals  - the values, in queue order
+ *        count - how many
+ * @return none
+ *****************************************************************************/
+template <class P>
+void basic_msqueue<P>::enqueue_batch(const int * vals, size_t count)
+{
+    node * t, * e;
+    node * dummy = NULL;
+    unsigned long attempts = 0;
+    backoff b;
+    if (count == 0)
+    {
+        return;
+    }
+    node * first = new node(vals[0]);
+    node * last = first;
+    for (size_t i = 1; i < count; ++i)
+    {
+        node * n = new node(vals[i]);
+        last->next.store(n, memory_order_relaxed);
+        last = n;
+    }
+    Reclaim_Enter();
+    while(true) 
+    {
+        ++attempts;
+        t = Reclaim_Protect(0, tail);
+        e = t->next.load(P::load);
+        if (t == tail.load(P::load))
+        {
+            if (e == NULL && t->next.compare_exchange_weak(dummy, first, P::cas, P::casFail)) 
+            {
+                break;
+            }
+        }
+        else 
+        {
+            tail.compare_exchange_weak(t, e, P::cas, P::casFail);
+        }
+        b.pause();
+    }
+    tail.compare_exchange_weak(t, last, P::cas, P::casFail);
+    Reclaim_Exit();
+    Retry_Max(maxEnqRetries, attempts - 1);
+    ready.notify(count);
+}
+
+/******************************************************************************
+ * @brief msqueue::dequeue_batch - Dequeues up to count values with one CAS on
+ *                                 head. While head is still h nothing after
+ *                                 it can have been dequeued, so each step is
+ *                                 protected hand over hand (slots 1 and 2)
+ *                                 and checked against head. The walk stops
+ *                                 at tail so head never passes it.
+ * @param vals  - where the values go, oldest first
+ *        count - room in vals
+ * @return size_t - how many were dequeued, 0 if the queue is empty
+ *****************************************************************************/
+template <class P>
+size_t basic_msqueue<P>::dequeue_batch(int * vals, size_t count)
+{
+    node *t, *h, *last;
+    size_t taken;
+    unsigned long attempts = 0;
+    backoff b;
+    if (count == 0)
+    {
+        return 0;
+    }
+    Reclaim_Enter();
+    while(true){
+        ++attempts;
+        h = Reclaim_Protect(0, head);
+        t = tail.load(P::load); 
+        last = h;
+        for (taken = 0; taken < count; ++taken)
+        {
+            node * n = last->next.load(P::load);
+            if (n == NULL || last == t)
+            {
+                break;
+            }
+            Reclaim_Publish(1 + (taken & 1), n);
+            if (h != head.load(P::load))
+            {
+                break;
+            }
+            vals[taken] = n->val;
+            last = n;
+        }
+        if (h != head.load(P::load))
+        {
+            continue;
+        }
+        if (taken == 0)
+        {
+            node * n = h->next.load(P::load);
+            if (n == NULL)
+            {
+                Reclaim_Exit();
+                Retry_Max(maxDeqRetries, attempts - 1);
+                return 0;
+            }
+            tail.compare_exchange_weak(t, n, P::cas, P::casFail);    // Tail is lagging
+            continue;
+        }
+        if (head.compare_exchange_weak(h, last, P::cas, P::casFail))
+        {
+            break;
+        }
+        b.pause();
+    }
+    Reclaim_Exit();
+    for (size_t i = 0; i < taken; ++i)
+    {
+        node * n = h->next.load(P::load);
+        Reclaim_Retire(h);   // last is the new dummy
+        h = n;
+    }
+    Retry_Max(maxDeqRetries, attempts - 1);
+    return taken;
+}
+
+/******************************************************************************
+ * @brief msqueue::dequeue_all - Dequeues everything up to a snapshot of tail
+ *                               with one CAS, head going straight to it. The
+ *                               tail node stays behind as the new dummy, so
+ *                               it is kept protected (slot 1) until its value
+ *                               has been read.
+ * @param vals - the values get appended here oldest first, NULL drops them
+ * @return size_t - how many were dequeued
+ *****************************************************************************/
+template <class P>
+size_t basic_msqueue<P>::dequeue_all(vector<int> * vals)
+{
+    node *t, *h;
+    size_t taken = 0;
+    backoff b;
+    Reclaim_Enter();
+    while(true){
+        h = Reclaim_Protect(0, head);
+        t = Reclaim_Protect(1, tail);
+        if (h != head.load(P::load))
+        {
+            continue;
+        }
+        if (h == t)
+        {
+            Reclaim_Exit();
+            return 0;
+        }
+        if (head.compare_exchange_weak(h, t, P::cas, P::casFail))
+        {
+            break;
+        }
+        b.pause();
+    }
+    while (h != t)
+    {
+        node * n = h->next.load(P::load);
+        if (vals != NULL)
+        {
+            vals->push_back(n->val);
+        }
+        Reclaim_Retire(h);
+        h = n;
+        ++taken;
     }
+    Reclaim_Exit();
+    return taken;
 }
 
+// Every policy --policy can pick
+template class basic_msqueue<seqcst_policy>;
+template class basic_msqueue<acqrel_policy>;
+template class basic_msqueue<seqcst_padded_policy>;
+template class basic_msqueue<acqrel_padded_policy>;
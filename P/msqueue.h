@@ -3,26 +3,60 @@
 
 #include <atomic>
 #include <iostream>
+#include <vector>
+#include "reclaim.h"
+#include "pool.h"
+#include "policy.h"
+#include "backoff.h"
+#include "eventcount.h"
 
 #define DUMMY 0
 
 using namespace std;
 
-class msqueue 
+/******************************************************************************
+ * @brief Retry_Max - Raises max to retries if it is larger. Only the rare
+ *                    new maximum writes the shared line.
+ * @param max     - the running maximum
+ *        retries - this operation's failed attempts
+ * @return none
+ *****************************************************************************/
+inline void Retry_Max(atomic<unsigned long> & max, unsigned long retries)
+{
+    unsigned long seen = max.load(memory_order_relaxed);
+    while (retries > seen && !max.compare_exchange_weak(seen, retries, memory_order_relaxed))
+    {
+    }
+}
+
+template <class P>
+class basic_msqueue 
 {
     public:
-    class node 
+    class alignas(P::nodeAlign) node : public pooled
     {
         public:
-        node (int v) : val(v){}
+        node (int v) : val(v), next(NULL){}
         int val; 
         atomic<node *> next;
     };
-    atomic<node *> head, tail;
-    msqueue();
+    alignas(P::align) atomic<node *> head;
+    alignas(P::align) atomic<node *> tail;
+    alignas(P::align) atomic<unsigned long> maxEnqRetries;
+    atomic<unsigned long> maxDeqRetries;
+    eventcount ready;   // Wakes dequeue_wait callers
+    basic_msqueue();
+    ~basic_msqueue();
     void enqueue(int val);
     void print();
     int dequeue();
+    int dequeue_wait(const struct timespec * timeout);
+    void enqueue_batch(const int * vals, size_t count);
+    size_t dequeue_batch(int * vals, size_t count);
+    size_t dequeue_all(vector<int> * vals);
+    void report();
 };
 
+typedef basic_msqueue<seqcst_policy> msqueue;
+
 #endif
\ No newline at end of file
@@ -0,0 +1,231 @@
+#include "multiqueue.h"
+
+#include <algorithm>    // sort
+#include <new>          // bad_alloc, placement new
+#include <stdlib.h>     // posix_memalign
+
+/******************************************************************************
+ * Relaxed FIFO MultiQueue
+ * Credit goes to Hamza Rihani, Peter Sanders and Roman Dementiev -
+ * "MultiQueues: Simple Relaxed Concurrent Priority Queues" (SPAA 2015), with
+ * time stamps for priorities
+ *****************************************************************************/
+static thread_local unsigned mqSeed = 0;
+static thread_local int mqHome = -1;
+
+static unsigned MQ_Random(void)
+{
+    if (mqSeed == 0)
+    {
+        mqSeed = (unsigned)(size_t)&mqSeed | 1;     // Differs per thread
+    }
+    mqSeed ^= mqSeed << 13;
+    mqSeed ^= mqSeed >> 17;
+    mqSeed ^= mqSeed << 5;
+    return mqSeed;
+}
+
+multiqueue::multiqueue(int shards)
+{
+    shardCount = (shards < 1) ? 1 : shards;
+    // new only promises 16 bytes under C++11, the shards need a line each
+    void * raw = NULL;
+    if (posix_memalign(&raw, CACHE_LINE, shardCount * sizeof(shard)) != 0)
+    {
+        throw bad_alloc();
+    }
+    shardList = (shard *)raw;
+    for (int pos = 0; pos < shardCount; ++pos)
+    {
+        new (&shardList[pos]) shard;
+        shardList[pos].locked.store(false);
+        shardList[pos].headStamp.store(MQ_EMPTY_STAMP);
+    }
+}
+
+multiqueue::~multiqueue()
+{
+    for (int pos = 0; pos < shardCount; ++pos)
+    {
+        shardList[pos].~shard();
+    }
+    free(shardList);
+}
+
+int multiqueue::shards()
+{
+    return shardCount;
+}
+
+bool multiqueue::TryLock(shard * s)
+{
+    return !s->locked.load(memory_order_relaxed) &&
+           !s->locked.exchange(true, memory_order_acquire);
+}
+
+void multiqueue::Unlock(shard * s)
+{
+    s->locked.store(false, memory_order_release);
+}
+
+/******************************************************************************
+ * @brief multiqueue::enqueue - Appends val to the home shard, or to a random
+ *                              one if home is busy, which then becomes home
+ * @param val - the value being enqueued
+ * @return none
+ *****************************************************************************/
+void multiqueue::enqueue(int val)
+{
+    shard * s;
+    if (mqHome < 0 || mqHome >= shardCount)
+    {
+        mqHome = MQ_Random() % shardCount;
+    }
+    while (true)
+    {
+        s = &shardList[mqHome];
+        if (TryLock(s))
+        {
+            break;
+        }
+        mqHome = MQ_Random() % shardCount;
+    }
+    item i;
+    i.stamp = __builtin_ia32_rdtsc();   // Under the lock, so shard order is stamp order
+    i.val = val;
+    s->items.push(i);
+    if (s->items.size() == 1)
+    {
+        s->headStamp.store(i.stamp, memory_order_relaxed);
+    }
+    Unlock(s);
+}
+
+/******************************************************************************
+ * @brief multiqueue::Pop - Takes the oldest element of s, which the caller
+ *                          has locked and unlocks here
+ * @param s      - the shard
+ *        stamps - filled in when not NULL
+ * @return int - the value, -2 if s turned out to be empty
+ *****************************************************************************/
+int multiqueue::Pop(shard * s, mq_stamps * stamps)
+{
+    if (s->items.empty())
+    {
+        Unlock(s);
+        return -2;
+    }
+    item i = s->items.front();
+    s->items.pop();
+    if (stamps != NULL)
+    {
+        stamps->enq = i.stamp;
+        stamps->deq = __builtin_ia32_rdtsc();
+    }
+    s->headStamp.store(s->items.empty() ? MQ_EMPTY_STAMP : s->items.front().stamp,
+                       memory_order_relaxed);
+    Unlock(s);
+    return i.val;
+}
+
+/******************************************************************************
+ * @brief multiqueue::dequeue - Pops from the older of two random shards,
+ *                              falling back to a scan of every shard
+ * @param stamps - the element's enqueue and dequeue stamps go here, NULL to
+ *                 skip them
+ * @return int - the value or -2 == EMPTY
+ *****************************************************************************/
+int multiqueue::dequeue(mq_stamps * stamps)
+{
+    for (int sample = 0; sample < MQ_SAMPLES; ++sample)
+    {
+        shard * a = &shardList[MQ_Random() % shardCount];
+        shard * b = &shardList[MQ_Random() % shardCount];
+        unsigned long long stampA = a->headStamp.load(memory_order_relaxed);
+        unsigned long long stampB = b->headStamp.load(memory_order_relaxed);
+        shard * s = (stampB < stampA) ? b : a;
+        if (s->headStamp.load(memory_order_relaxed) == MQ_EMPTY_STAMP || !TryLock(s))
+        {
+            continue;
+        }
+        int val = Pop(s, stamps);
+        if (val != -2)
+        {
+            return val;
+        }
+    }
+    // Steal from whichever shard still has something
+    int start = MQ_Random() % shardCount;
+    for (int pos = 0; pos < shardCount; ++pos)
+    {
+        shard * s = &shardList[(start + pos) % shardCount];
+        if (s->headStamp.load(memory_order_relaxed) == MQ_EMPTY_STAMP)
+        {
+            continue;
+        }
+        while (!TryLock(s))
+        {
+            __builtin_ia32_pause();
+        }
+        int val = Pop(s, stamps);
+        if (val != -2)
+        {
+            return val;
+        }
+    }
+    return -2;
+}
+
+/******************************************************************************
+ * @brief MQ_RankError - How far from FIFO a run was. An element's rank error
+ *                       is the number of elements enqueued before it that
+ *                       were still queued when it was dequeued, 0 for every
+ *                       element of a strict FIFO queue.
+ * @param stamps - every dequeued element's stamps, reordered here
+ *        mean   - set to the mean rank error
+ *        max    - set to the largest
+ * @return none
+ *****************************************************************************/
+void MQ_RankError(vector<mq_stamps> & stamps, double * mean, unsigned long long * max)
+{
+    size_t n = stamps.size();
+    *mean = 0;
+    *max = 0;
+    if (n == 0)
+    {
+        return;
+    }
+    // Rank of each element in enqueue order
+    vector<unsigned long long> enqOrder(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        enqOrder[i] = stamps[i].enq;
+    }
+    sort(enqOrder.begin(), enqOrder.end());
+    sort(stamps.begin(), stamps.end(),
+         [](const mq_stamps & x, const mq_stamps & y) { return x.deq < y.deq; });
+    // Walk in dequeue order, a Fenwick tree counting the older elements
+    // already gone
+    vector<unsigned long long> gone(n + 1, 0);
+    unsigned long long total = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        size_t rank = lower_bound(enqOrder.begin(), enqOrder.end(), stamps[i].enq) - enqOrder.begin();
+        unsigned long long older = 0;
+        for (size_t pos = rank; pos > 0; pos -= pos & -pos)
+        {
+            older += gone[pos];
+        }
+        unsigned long long error = rank - older;
+        total += error;
+        if (error > *max)
+        {
+            *max = error;
+        }
+        for (size_t pos = rank + 1; pos <= n; pos += pos & -pos)
+        {
+            ++gone[pos];
+        }
+    }
+    *mean = (double)total / n;
+}
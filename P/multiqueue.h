@@ -0,0 +1,63 @@
+#ifndef MULTIQUEUE_H
+#define MULTIQUEUE_H
+
+#include <atomic>
+#include <queue>
+#include <vector>
+#include <limits.h>
+#include "ringqueue.h"  // CACHE_LINE
+
+using namespace std;
+
+#define MQ_SHARDS_PER_THREAD 2          // Default shards, --shards overrides
+#define MQ_EMPTY_STAMP       ULLONG_MAX // headStamp of an empty shard
+#define MQ_SAMPLES           4          // Two-choice rounds before a full scan
+
+/******************************************************************************
+ * Relaxed FIFO MultiQueue (Rihani, Sanders and Dementiev)
+ * K shards, each a short try-lock around a plain FIFO of (stamp, value)
+ * pairs. An enqueue stamps its value with the time stamp counter and
+ * appends it to the thread's home shard, moving home to a random shard
+ * whenever that one is busy. A dequeue picks two random shards, takes the
+ * one whose oldest element is older and pops it, so the result is close to
+ * the global oldest without anyone touching a shared word. After
+ * MQ_SAMPLES rounds that found only empty or busy shards it scans all of
+ * them before calling the queue empty. Each shard publishes the stamp of
+ * its oldest element so sampling reads need no lock.
+ *****************************************************************************/
+struct mq_stamps
+{
+    unsigned long long enq;     // When the value went in
+    unsigned long long deq;     // When it came out
+};
+
+class multiqueue
+{
+public:
+    struct item
+    {
+        unsigned long long stamp;
+        int val;
+    };
+    struct alignas(CACHE_LINE) shard
+    {
+        atomic<bool> locked;
+        atomic<unsigned long long> headStamp;
+        queue<item> items;
+    };
+    multiqueue(int shards);
+    ~multiqueue();
+    void enqueue(int val);
+    int dequeue(mq_stamps * stamps);
+    int shards();
+private:
+    shard * shardList;
+    int shardCount;
+    bool TryLock(shard * s);
+    void Unlock(shard * s);
+    int Pop(shard * s, mq_stamps * stamps);
+};
+
+void MQ_RankError(vector<mq_stamps> & stamps, double * mean, unsigned long long * max);
+
+#endif
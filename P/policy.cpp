@@ -0,0 +1,47 @@
+#include "policy.h"
+
+#include <string.h> // strcmp
+
+policy_t containerPolicy = POLICY_NATIVE_e;
+
+/******************************************************************************
+ * @brief Policy_Select - Picks the container policy from its command line name
+ * @param name - "seqcst", "acqrel", "seqcst_padded" or "acqrel_padded"
+ * @return false if the name is unknown
+ *****************************************************************************/
+bool Policy_Select(const char * name)
+{
+    if (strcmp(name, "seqcst") == 0)
+    {
+        containerPolicy = POLICY_SEQCST_e;
+    }
+    else if (strcmp(name, "acqrel") == 0)
+    {
+        containerPolicy = POLICY_ACQREL_e;
+    }
+    else if (strcmp(name, "seqcst_padded") == 0)
+    {
+        containerPolicy = POLICY_SEQCST_PADDED_e;
+    }
+    else if (strcmp(name, "acqrel_padded") == 0)
+    {
+        containerPolicy = POLICY_ACQREL_PADDED_e;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+const char * Policy_Name(void)
+{
+    switch (containerPolicy)
+    {
+        case (POLICY_SEQCST_e):        return "seqcst";
+        case (POLICY_ACQREL_e):        return "acqrel";
+        case (POLICY_SEQCST_PADDED_e): return "seqcst_padded";
+        case (POLICY_ACQREL_PADDED_e): return "acqrel_padded";
+        default:                       return "native";
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef POLICY_H
+#define POLICY_H
+
+#include <atomic>
+#include <stddef.h>
+#include "ringqueue.h"  // CACHE_LINE
+
+using namespace std;
+
+/******************************************************************************
+ * Container Policies
+ * msqueue and tstack are templates over one of these (basic_msqueue,
+ * basic_tstack). A policy picks the memory orders of the container's own
+ * loads and CASes, and how far apart its shared words and its nodes sit:
+ *   load      - loads of head, tail, top and next
+ *   cas       - a CAS that succeeds
+ *   casFail   - a CAS that fails, never stronger than cas
+ *   align     - alignment of head/tail (or top), CACHE_LINE puts each on a
+ *               line of its own
+ *   nodeAlign - alignment of each node. A node is only ever 64 byte aligned
+ *               in memory with --alloc=pool, new only pads its size
+ * Loads made through Reclaim_Protect keep that scheme's ordering. msqueue
+ * and tstack are still the versions the harness always ran, seqcst_policy
+ * and acqrel_policy respectively.
+ *****************************************************************************/
+struct seqcst_policy
+{
+    static const memory_order load    = memory_order_seq_cst;
+    static const memory_order cas     = memory_order_seq_cst;
+    static const memory_order casFail = memory_order_seq_cst;
+    static const size_t align         = alignof(atomic<void *>);
+    static const size_t nodeAlign     = alignof(void *);
+};
+
+struct acqrel_policy
+{
+    static const memory_order load    = memory_order_acquire;
+    static const memory_order cas     = memory_order_acq_rel;
+    static const memory_order casFail = memory_order_acquire;
+    static const size_t align         = alignof(atomic<void *>);
+    static const size_t nodeAlign     = alignof(void *);
+};
+
+struct seqcst_padded_policy : seqcst_policy
+{
+    static const size_t align         = CACHE_LINE;
+    static const size_t nodeAlign     = CACHE_LINE;
+};
+
+struct acqrel_padded_policy : acqrel_policy
+{
+    static const size_t align         = CACHE_LINE;
+    static const size_t nodeAlign     = CACHE_LINE;
+};
+
+/******************************************************************************
+ * Which instantiation the harness runs, --policy=seqcst|acqrel|
+ * seqcst_padded|acqrel_padded. Without the option each container keeps its
+ * own.
+ *****************************************************************************/
+typedef enum
+{
+    POLICY_NATIVE_e,
+    POLICY_SEQCST_e,
+    POLICY_ACQREL_e,
+    POLICY_SEQCST_PADDED_e,
+    POLICY_ACQREL_PADDED_e
+}policy_t;
+
+extern policy_t containerPolicy;
+
+bool Policy_Select(const char * name);
+const char * Policy_Name(void);
+
+#endif
@@ -0,0 +1,218 @@
+#include "pool.h"
+
+#include <new>
+#include <stdlib.h> // posix_memalign
+#include <string.h> // strcmp
+#include <pthread.h>
+
+struct pool_block
+{
+    pool_block * next;      // Free list link
+    pool_block * nextBatch; // Only meaningful on the first block of a batch
+    int count;              // Ditto
+};
+
+bool usePool = false;
+
+static pthread_mutex_t poolLock = PTHREAD_MUTEX_INITIALIZER;
+static pool_block * poolBatches = NULL;
+static unsigned long poolSlabs = 0;
+static unsigned long poolTransfers = 0;
+
+/******************************************************************************
+ * The free list itself is plain thread_local data so it is still usable while
+ * other thread_local destructors (the reclamation records) free nodes during
+ * thread exit. The owner only exists to give the blocks back afterwards.
+ *****************************************************************************/
+struct pool_local
+{
+    pool_block * head;
+    int count;
+    bool registered;
+    bool dead;
+};
+static thread_local pool_local poolLocal;
+
+static void Pool_PutBatch(pool_block * batch, int count);
+
+struct pool_owner
+{
+    ~pool_owner()
+    {
+        if (poolLocal.head != NULL)
+        {
+            Pool_PutBatch(poolLocal.head, poolLocal.count);
+        }
+        poolLocal.head = NULL;
+        poolLocal.count = 0;
+        poolLocal.dead = true;
+    }
+};
+static thread_local pool_owner poolOwner;
+
+static void Pool_Register(void)
+{
+    if (!poolLocal.registered)
+    {
+        (void)&poolOwner;   // First odr-use schedules the destructor
+        poolLocal.registered = true;
+    }
+}
+
+/******************************************************************************
+ * @brief Pool_Select - Picks the node allocator from its command line name
+ * @param name - "pool" or "new"
+ * @return false if the name is unknown
+ *****************************************************************************/
+bool Pool_Select(const char * name)
+{
+    if (strcmp(name, "pool") == 0)
+    {
+        usePool = true;
+    }
+    else if (strcmp(name, "new") == 0)
+    {
+        usePool = false;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+/******************************************************************************
+ * @brief Pool_PutBatch - Gives a chain of blocks to the global pool
+ * @param batch - first block, chained through next
+ *        count - number of blocks in the chain
+ * @return none
+ *****************************************************************************/
+static void Pool_PutBatch(pool_block * batch, int count)
+{
+    batch->count = count;
+    pthread_mutex_lock(&poolLock);
+    batch->nextBatch = poolBatches;
+    poolBatches = batch;
+    ++poolTransfers;
+    pthread_mutex_unlock(&poolLock);
+}
+
+/******************************************************************************
+ * @brief Pool_Refill - Moves one batch from the global pool to the calling
+ *                      thread, carving a new slab if the pool is empty
+ * @param none
+ * @return none
+ *****************************************************************************/
+static void Pool_Refill(void)
+{
+    Pool_Register();
+    pthread_mutex_lock(&poolLock);
+    if (poolBatches == NULL)
+    {
+        void * mem;
+        if (posix_memalign(&mem, POOL_BLOCK, POOL_BLOCK * POOL_BATCH * POOL_SLAB) != 0)
+        {
+            pthread_mutex_unlock(&poolLock);
+            throw std::bad_alloc();
+        }
+        ++poolSlabs;
+        char * base = (char *)mem;
+        for (int batch = 0; batch < POOL_SLAB; ++batch)
+        {
+            pool_block * first = (pool_block *)(base + batch * POOL_BATCH * POOL_BLOCK);
+            for (int block = 0; block < POOL_BATCH - 1; ++block)
+            {
+                pool_block * b = (pool_block *)((char *)first + block * POOL_BLOCK);
+                b->next = (pool_block *)((char *)b + POOL_BLOCK);
+            }
+            ((pool_block *)((char *)first + (POOL_BATCH - 1) * POOL_BLOCK))->next = NULL;
+            first->count = POOL_BATCH;
+            first->nextBatch = poolBatches;
+            poolBatches = first;
+        }
+    }
+    pool_block * batch = poolBatches;
+    poolBatches = batch->nextBatch;
+    ++poolTransfers;
+    pthread_mutex_unlock(&poolLock);
+
+    poolLocal.head = batch;
+    poolLocal.count = batch->count;
+}
+
+/******************************************************************************
+ * @brief Pool_Alloc - Takes a block off the thread's free list
+ * @param size - size of the node, larger than POOL_BLOCK goes to new
+ * @return the block
+ *****************************************************************************/
+void * Pool_Alloc(size_t size)
+{
+    if (!usePool || size > POOL_BLOCK)
+    {
+        return ::operator new(size);
+    }
+    if (poolLocal.head == NULL)
+    {
+        Pool_Refill();
+    }
+    pool_block * b = poolLocal.head;
+    poolLocal.head = b->next;
+    --poolLocal.count;
+    return b;
+}
+
+/******************************************************************************
+ * @brief Pool_Free - Puts a block on the thread's free list, handing a batch
+ *                    to the global pool once the list holds two of them
+ * @param ptr  - the block
+ *        size - size of the node, must match the one given to Pool_Alloc
+ * @return none
+ *****************************************************************************/
+void Pool_Free(void * ptr, size_t size)
+{
+    if (!usePool || size > POOL_BLOCK)
+    {
+        ::operator delete(ptr);
+        return;
+    }
+    pool_block * b = (pool_block *)ptr;
+    if (poolLocal.dead)
+    {
+        b->next = NULL;
+        Pool_PutBatch(b, 1);
+        return;
+    }
+    Pool_Register();
+    b->next = poolLocal.head;
+    poolLocal.head = b;
+    if (++poolLocal.count >= 2 * POOL_BATCH)
+    {
+        pool_block * batch = poolLocal.head;
+        pool_block * last = batch;
+        for (int block = 1; block < POOL_BATCH; ++block)
+        {
+            last = last->next;
+        }
+        poolLocal.head = last->next;
+        poolLocal.count -= POOL_BATCH;
+        last->next = NULL;
+        Pool_PutBatch(batch, POOL_BATCH);
+    }
+}
+
+/******************************************************************************
+ * @brief Pool_Report - Prints how much the pool took from the system
+ * @param none
+ * @return none
+ *****************************************************************************/
+void Pool_Report(void)
+{
+    if (!usePool)
+    {
+        return;
+    }
+    pthread_mutex_lock(&poolLock);
+    printf("Pool slabs: %lu (%lu KB) batch transfers: %lu\n", poolSlabs,
+           poolSlabs * POOL_BLOCK * POOL_BATCH * POOL_SLAB / 1024, poolTransfers);
+    pthread_mutex_unlock(&poolLock);
+}
@@ -0,0 +1,43 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#define POOL_BLOCK 64   // Every node gets its own cache line
+#define POOL_BATCH 64   // Blocks moved between a thread and the global pool at once
+#define POOL_SLAB  16   // Batches carved out of one fresh allocation
+
+/******************************************************************************
+ * Node Pool
+ * Each thread keeps a private free list of cache-line sized, cache-line
+ * aligned blocks. Only when that list runs dry, or grows past two batches,
+ * does the thread take the global pool's lock, and then it moves a whole
+ * batch of POOL_BATCH blocks at once. Blocks are never handed back to the
+ * system. With the pool off (the default) the nodes go to plain new/delete.
+ *****************************************************************************/
+extern bool usePool;
+
+bool Pool_Select(const char * name);
+void * Pool_Alloc(size_t size);
+void Pool_Free(void * ptr, size_t size);
+void Pool_Report(void);
+
+/******************************************************************************
+ * Container nodes inherit from pooled so that every `new node(...)` and the
+ * reclamation schemes' deletes go through the pool.
+ *****************************************************************************/
+class pooled
+{
+public:
+    static void * operator new(size_t size)
+    {
+        return Pool_Alloc(size);
+    }
+    static void operator delete(void * ptr, size_t size)
+    {
+        Pool_Free(ptr, size);
+    }
+};
+
+#endif
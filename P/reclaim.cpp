@@ -0,0 +1,90 @@
+#include "reclaim.h"
+
+#include <string.h> // strcmp
+
+reclaim_t reclaimScheme = RECLAIM_HP_e;
+
+/******************************************************************************
+ * @brief Reclaim_Select - Picks the scheme from its command line name
+ * @param name - "hp", "ebr" or "none"
+ * @return false if the name is unknown
+ *****************************************************************************/
+bool Reclaim_Select(const char * name)
+{
+    if (strcmp(name, "hp") == 0)
+    {
+        reclaimScheme = RECLAIM_HP_e;
+    }
+    else if (strcmp(name, "ebr") == 0)
+    {
+        reclaimScheme = RECLAIM_EBR_e;
+    }
+    else if (strcmp(name, "none") == 0)
+    {
+        reclaimScheme = RECLAIM_NONE_e;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+const char * Reclaim_Name(void)
+{
+    switch (reclaimScheme)
+    {
+        case (RECLAIM_HP_e):  return "hp";
+        case (RECLAIM_EBR_e): return "ebr";
+        default:              return "none";
+    }
+}
+
+/******************************************************************************
+ * @brief Reclaim_Retire - Hands an unlinked node to the selected scheme
+ * @param ptr     - the node, already unreachable from the container
+ *        deleter - how to free it
+ * @return none
+ *****************************************************************************/
+void Reclaim_Retire(void * ptr, void (* deleter)(void *))
+{
+    switch (reclaimScheme)
+    {
+        case (RECLAIM_HP_e):
+            HP_Retire(ptr, deleter);
+            break;
+        case (RECLAIM_EBR_e):
+            EBR_Retire(ptr, deleter);
+            break;
+        default:
+            break;  // Not counted, a shared counter would skew the baseline
+    }
+}
+
+/******************************************************************************
+ * @brief Reclaim_Flush - Frees whatever either scheme still holds. Only call
+ *                        this once all worker threads are joined.
+ * @param none
+ * @return none
+ *****************************************************************************/
+void Reclaim_Flush(void)
+{
+    HP_Flush();
+    EBR_Flush();
+}
+
+void Reclaim_Report(void)
+{
+    switch (reclaimScheme)
+    {
+        case (RECLAIM_HP_e):
+            HP_Report();
+            break;
+        case (RECLAIM_EBR_e):
+            EBR_Report();
+            break;
+        default:
+            printf("Reclaim none: retired nodes leaked\n");
+            break;
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef RECLAIM_H
+#define RECLAIM_H
+
+#include <atomic>
+#include "hazard.h"
+#include "epoch.h"
+
+using namespace std;
+
+/******************************************************************************
+ * Common reclamation interface for the lock-free containers. A container
+ * brackets every operation with Reclaim_Enter/Reclaim_Exit, loads any
+ * pointer it is going to dereference through Reclaim_Protect and hands
+ * unlinked nodes to Reclaim_Retire. The scheme is picked once at start up
+ * (--reclaim=hp|ebr|none) so the same workload can be timed under each.
+ *****************************************************************************/
+typedef enum
+{
+    RECLAIM_NONE_e,     // Leak, the original behaviour
+    RECLAIM_HP_e,       // Hazard pointers
+    RECLAIM_EBR_e       // Epoch based reclamation
+}reclaim_t;
+
+extern reclaim_t reclaimScheme;
+
+bool Reclaim_Select(const char * name);
+const char * Reclaim_Name(void);
+void Reclaim_Retire(void * ptr, void (* deleter)(void *));
+void Reclaim_Flush(void);
+void Reclaim_Report(void);
+
+inline void Reclaim_Enter(void)
+{
+    if (reclaimScheme == RECLAIM_EBR_e)
+    {
+        EBR_Enter();
+    }
+}
+
+inline void Reclaim_Exit(void)
+{
+    if (reclaimScheme == RECLAIM_HP_e)
+    {
+        HP_Clear();
+    }
+    else if (reclaimScheme == RECLAIM_EBR_e)
+    {
+        EBR_Exit();
+    }
+}
+
+/******************************************************************************
+ * @brief Reclaim_Protect - Loads src for dereferencing. Only hazard pointers
+ *                          need a slot, the other schemes do a plain load.
+ * @param slot - hazard slot to publish in, below HP_PER_THREAD
+ *        src  - the shared pointer
+ * @return the pointer, safe to dereference until Reclaim_Exit
+ *****************************************************************************/
+template <class T>
+T * Reclaim_Protect(int slot, atomic<T *> & src)
+{
+    if (reclaimScheme == RECLAIM_HP_e)
+    {
+        return HP_Protect(slot, src);
+    }
+    return src.load(memory_order_acquire);
+}
+
+/******************************************************************************
+ * @brief Reclaim_Publish - Like Reclaim_Protect for pointers that do not live
+ *                          in an atomic<T *>. The caller re-reads the source
+ *                          afterwards and retries if it changed.
+ * @param slot - hazard slot to publish in, below HP_PER_THREAD
+ *        ptr  - the node about to be dereferenced
+ * @return none
+ *****************************************************************************/
+inline void Reclaim_Publish(int slot, void * ptr)
+{
+    if (reclaimScheme == RECLAIM_HP_e)
+    {
+        HP_Publish(slot, ptr);
+    }
+}
+
+template <class T>
+void Reclaim_Delete(void * ptr)
+{
+    delete (T *)ptr;
+}
+
+template <class T>
+void Reclaim_Retire(T * ptr)
+{
+    Reclaim_Retire((void *)ptr, Reclaim_Delete<T>);
+}
+
+#endif
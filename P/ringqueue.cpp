@@ -0,0 +1,119 @@
+#include "ringqueue.h"
+
+/******************************************************************************
+ * Bounded MPMC Ring Queue
+ * Credit goes to Dmitry Vyukov - "Bounded MPMC queue", 1024cores.net
+ *****************************************************************************/
+ringqueue::ringqueue(size_t capacity)
+{
+    size_t size = 2;
+    while (size < capacity)
+    {
+        size <<= 1;
+    }
+    buffer = new cell[size];
+    mask = size - 1;
+    for (size_t pos = 0; pos < size; ++pos)
+    {
+        buffer[pos].sequence.store(pos, memory_order_relaxed);
+    }
+    enqueuePos.store(0, memory_order_relaxed);
+    dequeuePos.store(0, memory_order_relaxed);
+}
+
+ringqueue::~ringqueue()
+{
+    delete[] buffer;
+}
+
+size_t ringqueue::capacity()
+{
+    return mask + 1;
+}
+
+/******************************************************************************
+ * @brief ringqueue::size - Claimed enqueue slots minus claimed dequeue ones.
+ *                          Only a snapshot while other threads are running.
+ * @param none
+ * @return size_t - about how many values are queued
+ *****************************************************************************/
+size_t ringqueue::size()
+{
+    size_t d = dequeuePos.load(memory_order_relaxed);
+    size_t e = enqueuePos.load(memory_order_relaxed);
+    return (e > d) ? e - d : 0;
+}
+
+/******************************************************************************
+ * @brief ringqueue::try_enqueue - Claims the next slot if it is free
+ * @param val - the value being enqueued
+ * @return bool - false if the queue is full
+ *****************************************************************************/
+bool ringqueue::try_enqueue(int val)
+{
+    cell * c;
+    backoff b;
+    size_t pos = enqueuePos.load(memory_order_relaxed);
+    while (true)
+    {
+        c = &buffer[pos & mask];
+        size_t seq = c->sequence.load(memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0)
+        {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+            {
+                break;
+            }
+            b.pause();
+        }
+        else if (diff < 0)
+        {
+            return false;   // Slot still holds last lap's value
+        }
+        else
+        {
+            pos = enqueuePos.load(memory_order_relaxed);
+        }
+    }
+    c->data = val;
+    c->sequence.store(pos + 1, memory_order_release);
+    return true;
+}
+
+/******************************************************************************
+ * @brief ringqueue::try_dequeue - Takes the oldest value if there is one
+ * @param val - set to the dequeued value
+ * @return bool - false if the queue is empty
+ *****************************************************************************/
+bool ringqueue::try_dequeue(int & val)
+{
+    cell * c;
+    backoff b;
+    size_t pos = dequeuePos.load(memory_order_relaxed);
+    while (true)
+    {
+        c = &buffer[pos & mask];
+        size_t seq = c->sequence.load(memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (diff == 0)
+        {
+            if (dequeuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+            {
+                break;
+            }
+            b.pause();
+        }
+        else if (diff < 0)
+        {
+            return false;   // Nothing enqueued in this slot yet
+        }
+        else
+        {
+            pos = dequeuePos.load(memory_order_relaxed);
+        }
+    }
+    val = c->data;
+    c->sequence.store(pos + mask + 1, memory_order_release);
+    return true;
+}
@@ -0,0 +1,47 @@
+#ifndef RINGQUEUE_H
+#define RINGQUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include "backoff.h"
+
+using namespace std;
+
+#define RING_CAPACITY 65536     // Default slots, rounded up to a power of two
+#define CACHE_LINE    64
+
+/******************************************************************************
+ * Bounded MPMC Ring Queue (Dmitry Vyukov)
+ * A fixed array of slots, each with a sequence number telling whose turn it
+ * is. An enqueuer at position pos owns the slot once its sequence equals
+ * pos and hands it on by setting it to pos + 1; the dequeuer then sets it to
+ * pos + capacity for the enqueuer one lap later. A full or empty queue is
+ * reported straight away rather than waited on, and nothing is allocated
+ * after construction.
+ *****************************************************************************/
+class ringqueue
+{
+public:
+    struct cell
+    {
+        atomic<size_t> sequence;
+        int data;
+    };
+    ringqueue(size_t capacity);
+    ~ringqueue();
+    bool try_enqueue(int val);
+    bool try_dequeue(int & val);
+    size_t capacity();
+    size_t size();
+private:
+    cell * buffer;
+    size_t mask;
+    char pad0[CACHE_LINE - sizeof(cell *) - sizeof(size_t)];
+    atomic<size_t> enqueuePos;
+    char pad1[CACHE_LINE - sizeof(atomic<size_t>)];
+    atomic<size_t> dequeuePos;
+    char pad2[CACHE_LINE - sizeof(atomic<size_t>)];
+};
+
+#endif
@@ -96,3 +96,38 @@ void SGL_Queue_Dequeue(std::queue<int> * queue)
     }
     pthread_mutex_unlock(&singleGlobalLock);
 }
+
+/******************************************************************************
+ * SGL Priority Queue
+ *****************************************************************************/
+/******************************************************************************
+ * @brief SGL_PQ_Insert - Simple global lock around the push. Uses
+ *                        priority_queue library for faster prototyping.
+ * @param pq   - the min priority queue passed in
+ *        item - the integer wanting to be in the queue
+ * @return none
+ *****************************************************************************/  
+void SGL_PQ_Insert(minQueue * pq, int item)
+{
+    pthread_mutex_lock(&singleGlobalLock);
+    pq->push(item);
+    pthread_mutex_unlock(&singleGlobalLock);
+}
+/******************************************************************************
+ * @brief SGL_PQ_Delete_Min - Simple global lock around the pop. Uses
+ *                            priority_queue library for faster prototyping.
+ * @param pq - the min priority queue passed in
+ * @return int - the smallest item or -2 == EMPTY
+ *****************************************************************************/  
+int SGL_PQ_Delete_Min(minQueue * pq)
+{
+    int item = -2;
+    pthread_mutex_lock(&singleGlobalLock);
+    if (!pq->empty())
+    {
+        item = pq->top();
+        pq->pop();
+    }
+    pthread_mutex_unlock(&singleGlobalLock);
+    return item;
+}
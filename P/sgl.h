@@ -4,8 +4,13 @@
 #include <stack>
 #include <iostream>
 #include <queue>
+#include <vector>
+#include <functional>
+#include <utility>
 #include <pthread.h>
 
+extern pthread_mutex_t singleGlobalLock;
+
 typedef struct {
     int loops;
     std::stack<int> * lifoStack;
@@ -16,6 +21,13 @@ typedef struct {
     std::queue<int> * fifoQueue;
 }sglQueueStruct;
 
+typedef std::priority_queue<int, std::vector<int>, std::greater<int> > minQueue;
+
+typedef struct {
+    int loops;
+    minQueue * minPQ;
+}sglPQStruct;
+
  
 void SGL_Stack_Push(std::stack<int> * stack, int item);
 void SGL_Stack_Pop(std::stack<int> * stack);
@@ -23,4 +35,58 @@ void SGL_Stack_Pop(std::stack<int> * stack);
 void SGL_Queue_Enqueue(std::queue<int> * queue, int item);
 void SGL_Queue_Dequeue(std::queue<int> * queue);
 
+void SGL_PQ_Insert(minQueue * pq, int item);
+int SGL_PQ_Delete_Min(minQueue * pq);
+
+/******************************************************************************
+ * Typed SGL Stack/Queue - the same global lock around std::stack<T> and
+ * std::queue<T> for any payload, move-only ones included. The value is
+ * constructed in place and moved out, and emptiness is the bool result.
+ *****************************************************************************/
+template <class T, class... Args>
+void SGL_Stack_Emplace(std::stack<T> * stack, Args &&... args)
+{
+    pthread_mutex_lock(&singleGlobalLock);
+    stack->emplace(std::forward<Args>(args)...);
+    pthread_mutex_unlock(&singleGlobalLock);
+}
+
+template <class T>
+bool SGL_Stack_Try_Pop(std::stack<T> * stack, T & out)
+{
+    bool taken = false;
+    pthread_mutex_lock(&singleGlobalLock);
+    if (!stack->empty())
+    {
+        out = std::move(stack->top());
+        stack->pop();
+        taken = true;
+    }
+    pthread_mutex_unlock(&singleGlobalLock);
+    return taken;
+}
+
+template <class T, class... Args>
+void SGL_Queue_Emplace(std::queue<T> * queue, Args &&... args)
+{
+    pthread_mutex_lock(&singleGlobalLock);
+    queue->emplace(std::forward<Args>(args)...);
+    pthread_mutex_unlock(&singleGlobalLock);
+}
+
+template <class T>
+bool SGL_Queue_Try_Dequeue(std::queue<T> * queue, T & out)
+{
+    bool taken = false;
+    pthread_mutex_lock(&singleGlobalLock);
+    if (!queue->empty())
+    {
+        out = std::move(queue->front());
+        queue->pop();
+        taken = true;
+    }
+    pthread_mutex_unlock(&singleGlobalLock);
+    return taken;
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,286 @@
+#include "shmqueue.h"
+#include <fcntl.h>
+#include <new>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/******************************************************************************
+ * Inter-process MS Queue
+ * Credit goes to Maged Michael and Michael Scott - "Simple, Fast, and
+ * Practical Non-Blocking and Blocking Concurrent Queue Algorithms"
+ *****************************************************************************/
+static inline uint32_t Offset(uint64_t link)
+{
+    return (uint32_t)link;
+}
+
+static inline uint64_t Link(uint32_t offset, uint64_t old)
+{
+    return (((old >> 32) + 1) << 32) | offset;
+}
+
+/******************************************************************************
+ * @brief shmqueue::Create - Sizes a new region for nodes nodes, maps it and
+ *                           sets up an empty queue in it
+ * @param name  - POSIX shm name such as "/queue", NULL for an anonymous
+ *                memfd that only children forked afterwards can see
+ *        nodes - how many values the region can hold at once
+ * @return shmqueue * - the queue, NULL if the region could not be made
+ *****************************************************************************/
+shmqueue * shmqueue::Create(const char * name, uint32_t nodes)
+{
+    uint64_t size = sizeof(shmqueue) + ((uint64_t)nodes + 1) * sizeof(node);
+    if (nodes == 0 || size > UINT32_MAX)
+    {
+        return NULL;
+    }
+    int fd = (name == NULL) ? memfd_create("shmqueue", 0) : shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    if (ftruncate(fd, size) != 0)
+    {
+        close(fd);
+        return NULL;
+    }
+    void * region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (region == MAP_FAILED)
+    {
+        return NULL;
+    }
+    shmqueue * q = new (region) shmqueue;
+    q->Init(size, nodes);
+    return q;
+}
+
+/******************************************************************************
+ * @brief shmqueue::Attach - Maps a region another process made with Create
+ * @param name - the name it was created with
+ * @return shmqueue * - the queue, NULL if there is no such ready region
+ *****************************************************************************/
+shmqueue * shmqueue::Attach(const char * name)
+{
+    int fd = shm_open(name, O_RDWR, 0600);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(shmqueue))
+    {
+        close(fd);
+        return NULL;
+    }
+    void * region = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (region == MAP_FAILED)
+    {
+        return NULL;
+    }
+    shmqueue * q = (shmqueue *)region;
+    if (__atomic_load_n(&q->magic, __ATOMIC_ACQUIRE) != SHM_MAGIC || q->bytes != (uint64_t)st.st_size)
+    {
+        munmap(region, st.st_size);
+        return NULL;
+    }
+    return q;
+}
+
+/******************************************************************************
+ * @brief shmqueue::Detach - Unmaps the region from this process. The queue
+ *                           lives on for everyone else still attached.
+ * @param q - from Create or Attach
+ * @return none
+ *****************************************************************************/
+void shmqueue::Detach(shmqueue * q)
+{
+    munmap(q, q->bytes);
+}
+
+/******************************************************************************
+ * @brief shmqueue::Unlink - Removes the name, the memory goes once the last
+ *                           process detaches
+ * @param name - the name it was created with
+ * @return none
+ *****************************************************************************/
+void shmqueue::Unlink(const char * name)
+{
+    shm_unlink(name);
+}
+
+/******************************************************************************
+ * @brief shmqueue::Init - Puts the first node up as the dummy and every
+ *                         other one on the free list, then publishes magic
+ *****************************************************************************/
+void shmqueue::Init(uint64_t size, uint32_t nodes)
+{
+    bytes = size;
+    nodeCount = nodes;
+    uint32_t first = sizeof(shmqueue);
+    uint32_t last = first + nodes * sizeof(node);
+    for (uint32_t offset = first; offset <= last; offset += sizeof(node))
+    {
+        node * n = new (Node(offset)) node;
+        n->next.store((offset == first || offset == last) ? 0 : offset + sizeof(node), memory_order_relaxed);
+        n->val.store(0, memory_order_relaxed);
+    }
+    head.store(first, memory_order_relaxed);
+    tail.store(first, memory_order_relaxed);
+    freeList.store(first + sizeof(node), memory_order_relaxed);
+    fullCount.store(0, memory_order_relaxed);
+    __atomic_store_n(&magic, SHM_MAGIC, __ATOMIC_RELEASE);
+}
+
+shmqueue::node * shmqueue::Node(uint32_t offset)
+{
+    return (node *)((char *)this + offset);
+}
+
+uint32_t shmqueue::capacity()
+{
+    return nodeCount;
+}
+
+/******************************************************************************
+ * @brief shmqueue::Alloc - Pops a node off the region's free list
+ * @param none
+ * @return uint32_t - its offset, 0 if every node is in the queue
+ *****************************************************************************/
+uint32_t shmqueue::Alloc()
+{
+    backoff b;
+    uint64_t top = freeList.load(memory_order_acquire);
+    while (Offset(top) != 0)
+    {
+        // A stale top still points into the region, the tag fails the CAS
+        uint64_t next = Node(Offset(top))->next.load(memory_order_relaxed);
+        if (freeList.compare_exchange_weak(top, Link(Offset(next), top), memory_order_acq_rel))
+        {
+            return Offset(top);
+        }
+        b.pause();
+    }
+    return 0;
+}
+
+/******************************************************************************
+ * @brief shmqueue::Free - Pushes a node back onto the region's free list
+ * @param offset - the node
+ * @return none
+ *****************************************************************************/
+void shmqueue::Free(uint32_t offset)
+{
+    backoff b;
+    node * n = Node(offset);
+    uint64_t top = freeList.load(memory_order_relaxed);
+    while (true)
+    {
+        n->next.store(Link(Offset(top), n->next.load(memory_order_relaxed)), memory_order_relaxed);
+        if (freeList.compare_exchange_weak(top, Link(offset, top), memory_order_release, memory_order_relaxed))
+        {
+            return;
+        }
+        b.pause();
+    }
+}
+
+/******************************************************************************
+ * @brief shmqueue::enqueue - Appends val, linking a node from the free list
+ * @param val - the value being enqueued
+ * @return bool - false if the region has no free node left
+ *****************************************************************************/
+bool shmqueue::enqueue(int val)
+{
+    uint32_t offset = Alloc();
+    if (offset == 0)
+    {
+        fullCount.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+    node * n = Node(offset);
+    n->val.store(val, memory_order_relaxed);
+    n->next.store(Link(0, n->next.load(memory_order_relaxed)), memory_order_relaxed);
+    backoff b;
+    uint64_t t;
+    while (true)
+    {
+        t = tail.load(memory_order_acquire);
+        uint64_t next = Node(Offset(t))->next.load(memory_order_acquire);
+        if (t != tail.load(memory_order_acquire))
+        {
+            continue;
+        }
+        if (Offset(next) == 0)
+        {
+            if (Node(Offset(t))->next.compare_exchange_strong(next, Link(offset, next), memory_order_acq_rel))
+            {
+                break;
+            }
+            b.pause();
+        }
+        else
+        {
+            // Tail fell behind, help it along
+            tail.compare_exchange_strong(t, Link(Offset(next), t), memory_order_acq_rel);
+        }
+    }
+    tail.compare_exchange_strong(t, Link(offset, t), memory_order_acq_rel);
+    return true;
+}
+
+/******************************************************************************
+ * @brief shmqueue::dequeue - Takes the value after the dummy, which becomes
+ *                            the new dummy, and frees the old one
+ * @param none
+ * @return int - the value, -2 if the queue is empty
+ *****************************************************************************/
+int shmqueue::dequeue()
+{
+    backoff b;
+    uint64_t h;
+    int val;
+    while (true)
+    {
+        h = head.load(memory_order_acquire);
+        uint64_t t = tail.load(memory_order_acquire);
+        uint64_t next = Node(Offset(h))->next.load(memory_order_acquire);
+        if (h != head.load(memory_order_acquire))
+        {
+            continue;
+        }
+        if (Offset(h) == Offset(t))
+        {
+            if (Offset(next) == 0)
+            {
+                return -2;
+            }
+            tail.compare_exchange_strong(t, Link(Offset(next), t), memory_order_acq_rel);
+            continue;
+        }
+        // Read before the CAS, after it the node may already be reused
+        val = Node(Offset(next))->val.load(memory_order_relaxed);
+        if (head.compare_exchange_strong(h, Link(Offset(next), h), memory_order_acq_rel))
+        {
+            break;
+        }
+        b.pause();
+    }
+    Free(Offset(h));
+    return val;
+}
+
+/******************************************************************************
+ * @brief shmqueue::report - Prints the region size and how often an enqueue
+ *                           found every node in use
+ * @param none
+ * @return none
+ *****************************************************************************/
+void shmqueue::report()
+{
+    printf("SHM region bytes: %llu nodes: %u full: %llu\n", (unsigned long long)bytes, nodeCount,
+           (unsigned long long)fullCount.load());
+}
@@ -0,0 +1,72 @@
+#ifndef SHMQUEUE_H
+#define SHMQUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include "ringqueue.h"  // CACHE_LINE
+#include "backoff.h"
+
+using namespace std;
+
+#define SHM_MAGIC 0x53484d5155455545ULL  // "SHMQUEUE", set once the region is ready
+#define SHM_NODES 65536                  // Default nodes carved out of a region
+
+/******************************************************************************
+ * Inter-process MS Queue
+ * The queue, its nodes and its free list all live in one shared mapping, so
+ * any process that maps the region can enqueue and dequeue. The region may
+ * be mapped at a different address in every process, so links are byte
+ * offsets from the start of the region rather than pointers, and offset 0
+ * (the header) stands for NULL.
+ *
+ * Nodes never leave the region, they go back on its free list, so a stale
+ * offset always points at some node and reading through it is safe. Each
+ * link carries a 32-bit tag bumped on every change, which stops a CAS
+ * from succeeding on a node that was freed and reused in between (ABA).
+ * This is the counted pointer form of the original Michael and Scott paper,
+ * and it needs neither hazard pointers nor epochs, which could not see the
+ * other processes anyway.
+ *
+ * Create builds a region in a named POSIX shm object, or in an anonymous
+ * memfd for NULL that children inherit across fork. Attach maps an
+ * existing named region, Detach unmaps it and Unlink removes the name. A
+ * process that dies in the middle of an operation can leave a node off
+ * both lists, but the queue itself stays consistent.
+ *****************************************************************************/
+class shmqueue
+{
+public:
+    struct node
+    {
+        atomic<uint64_t> next;  // tag << 32 | offset
+        atomic<int> val;
+    };
+    static shmqueue * Create(const char * name, uint32_t nodes);
+    static shmqueue * Attach(const char * name);
+    static void Detach(shmqueue * q);
+    static void Unlink(const char * name);
+    bool enqueue(int val);
+    int dequeue();
+    uint32_t capacity();
+    void report();
+private:
+    uint64_t magic;
+    uint64_t bytes;
+    uint32_t nodeCount;
+    char pad0[CACHE_LINE - 2 * sizeof(uint64_t) - sizeof(uint32_t)];
+    atomic<uint64_t> head;
+    char pad1[CACHE_LINE - sizeof(atomic<uint64_t>)];
+    atomic<uint64_t> tail;
+    char pad2[CACHE_LINE - sizeof(atomic<uint64_t>)];
+    atomic<uint64_t> freeList;
+    atomic<uint64_t> fullCount;
+    char pad3[CACHE_LINE - 2 * sizeof(atomic<uint64_t>)];
+    shmqueue() {}
+    void Init(uint64_t size, uint32_t nodes);
+    node * Node(uint32_t offset);
+    uint32_t Alloc();
+    void Free(uint32_t offset);
+};
+
+#endif
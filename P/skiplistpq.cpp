@@ -0,0 +1,289 @@
+#include "skiplistpq.h"
+
+#include <new>  // placement new
+
+/******************************************************************************
+ * Lock-Free Skiplist Priority Queue
+ * Credit goes to Jonatan Linden and Bengt Jonsson - "A Skiplist-Based
+ * Concurrent Priority Queue with Minimal Memory Contention" (OPODIS 2013)
+ *****************************************************************************/
+static thread_local unsigned pqSeed = 0;
+
+static inline bool PQ_Marked(uintptr_t p)
+{
+    return (p & 1) != 0;
+}
+
+static inline skiplistpq::node * PQ_Node(uintptr_t p)
+{
+    return (skiplistpq::node *)(p & ~(uintptr_t)1);
+}
+
+static inline void PQ_Enter(void)
+{
+    if (reclaimScheme != RECLAIM_NONE_e)
+    {
+        EBR_Enter();
+    }
+}
+
+static inline void PQ_Exit(void)
+{
+    if (reclaimScheme != RECLAIM_NONE_e)
+    {
+        EBR_Exit();
+    }
+}
+
+/******************************************************************************
+ * @brief PQ_Level - Random height, each level half as likely as the last
+ * @param none
+ * @return int - between 1 and PQ_MAX_LEVEL
+ *****************************************************************************/
+static int PQ_Level(void)
+{
+    if (pqSeed == 0)
+    {
+        pqSeed = (unsigned)(size_t)&pqSeed | 1;     // Differs per thread
+    }
+    pqSeed ^= pqSeed << 13;
+    pqSeed ^= pqSeed >> 17;
+    pqSeed ^= pqSeed << 5;
+    int height = 1;
+    for (unsigned bits = pqSeed; (bits & 1) && height < PQ_MAX_LEVEL; bits >>= 1)
+    {
+        ++height;
+    }
+    return height;
+}
+
+/******************************************************************************
+ * @brief skiplistpq::node::Create - Allocates a node with its next pointers
+ *                                   in line, so a search step touches one
+ *                                   cache line rather than two
+ * @param k      - the key
+ *        height - levels the node is linked on
+ * @return node * - the node, unlinked
+ *****************************************************************************/
+skiplistpq::node * skiplistpq::node::Create(int k, int height)
+{
+    node * n = (node *)::operator new(sizeof(node) + (height - 1) * sizeof(atomic<uintptr_t>));
+    n->key = k;
+    n->level = height;
+    new (&n->inserting) atomic<bool>(false);
+    for (int i = 0; i < height; ++i)
+    {
+        new (&n->next[i]) atomic<uintptr_t>(0);
+    }
+    return n;
+}
+
+void skiplistpq::node::Destroy(void * n)
+{
+    ::operator delete(n);
+}
+
+skiplistpq::skiplistpq()
+{
+    head = node::Create(INT_MIN, PQ_MAX_LEVEL);
+    tail = node::Create(PQ_TAIL_KEY, PQ_MAX_LEVEL);
+    for (int i = 0; i < PQ_MAX_LEVEL; ++i)
+    {
+        head->next[i].store((uintptr_t)tail, memory_order_relaxed);
+    }
+}
+
+/******************************************************************************
+ * @brief skiplistpq::~skiplistpq - Frees the bottom level, deleted nodes
+ *                                  included. Cut off prefixes belong to the
+ *                                  retire lists.
+ *****************************************************************************/
+skiplistpq::~skiplistpq()
+{
+    node * n = head;
+    while (n != NULL)
+    {
+        node * following = PQ_Node(n->next[0].load());
+        node::Destroy(n);
+        n = following;
+    }
+}
+
+/******************************************************************************
+ * @brief skiplistpq::LocatePreds - Finds on every level the last node before
+ *                                  key, stepping over the deleted prefix on
+ *                                  the bottom level
+ * @param key   - the key being inserted
+ *        preds - set to the predecessor on each level
+ *        succs - set to the successor on each level
+ * @return node * - the last deleted node seen on the bottom level, or NULL
+ *****************************************************************************/
+skiplistpq::node * skiplistpq::LocatePreds(int key, node ** preds, node ** succs)
+{
+    node * pred = head;
+    node * deleted = NULL;
+    for (int i = PQ_MAX_LEVEL - 1; i >= 0; --i)
+    {
+        uintptr_t raw = pred->next[i].load(memory_order_acquire);
+        bool d = PQ_Marked(raw);
+        node * cur = PQ_Node(raw);
+        while (cur->key < key || PQ_Marked(cur->next[0].load(memory_order_acquire)) || (i == 0 && d))
+        {
+            if (i == 0 && d)
+            {
+                deleted = cur;
+            }
+            pred = cur;
+            raw = pred->next[i].load(memory_order_acquire);
+            d = PQ_Marked(raw);
+            cur = PQ_Node(raw);
+        }
+        preds[i] = pred;
+        succs[i] = cur;
+    }
+    return deleted;
+}
+
+/******************************************************************************
+ * @brief skiplistpq::insert - Links key in at the bottom level, then on the
+ *                             levels above until the node or its successor
+ *                             turns out to be deleted
+ * @param key - the key being inserted, below PQ_TAIL_KEY
+ * @return none
+ *****************************************************************************/
+void skiplistpq::insert(int key)
+{
+    node * preds[PQ_MAX_LEVEL];
+    node * succs[PQ_MAX_LEVEL];
+    node * n = node::Create(key, PQ_Level());
+    n->inserting.store(true, memory_order_relaxed);
+    PQ_Enter();
+    node * deleted;
+    uintptr_t expected;
+    do
+    {
+        deleted = LocatePreds(key, preds, succs);
+        n->next[0].store((uintptr_t)succs[0], memory_order_relaxed);
+        expected = (uintptr_t)succs[0];
+    } while (!preds[0]->next[0].compare_exchange_strong(expected, (uintptr_t)n, memory_order_acq_rel));
+    int i = 1;
+    while (i < n->level)
+    {
+        n->next[i].store((uintptr_t)succs[i], memory_order_relaxed);
+        if (PQ_Marked(n->next[0].load(memory_order_acquire)) ||
+            PQ_Marked(succs[i]->next[0].load(memory_order_acquire)) ||
+            deleted == succs[i])
+        {
+            break;  // Deleted meanwhile, the upper levels are not worth it
+        }
+        expected = (uintptr_t)succs[i];
+        if (preds[i]->next[i].compare_exchange_strong(expected, (uintptr_t)n, memory_order_acq_rel))
+        {
+            ++i;
+        }
+        else
+        {
+            deleted = LocatePreds(key, preds, succs);
+            if (succs[0] != n)
+            {
+                break;
+            }
+        }
+    }
+    n->inserting.store(false, memory_order_release);
+    PQ_Exit();
+}
+
+/******************************************************************************
+ * @brief skiplistpq::Restructure - Moves the head's upper level pointers past
+ *                                  nodes that are deleted
+ * @param none
+ * @return none
+ *****************************************************************************/
+void skiplistpq::Restructure(void)
+{
+    node * pred = head;
+    int i = PQ_MAX_LEVEL - 1;
+    while (i > 0)
+    {
+        uintptr_t h = head->next[i].load(memory_order_acquire);
+        node * cur = PQ_Node(pred->next[i].load(memory_order_acquire));
+        if (!PQ_Marked(PQ_Node(h)->next[0].load(memory_order_acquire)))
+        {
+            --i;
+            continue;
+        }
+        while (PQ_Marked(cur->next[0].load(memory_order_acquire)))
+        {
+            pred = cur;
+            cur = PQ_Node(pred->next[i].load(memory_order_acquire));
+        }
+        if (head->next[i].compare_exchange_strong(h, pred->next[i].load(memory_order_acquire),
+                                                  memory_order_acq_rel))
+        {
+            --i;
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief skiplistpq::delete_min - Claims the first node past the deleted
+ *                                 prefix, cutting the prefix off once it is
+ *                                 longer than PQ_BOUND_OFFSET
+ * @param none
+ * @return int - the smallest key or -2 == EMPTY
+ *****************************************************************************/
+int skiplistpq::delete_min()
+{
+    PQ_Enter();
+    node * x = head;
+    node * newHead = NULL;
+    uintptr_t observedHead = head->next[0].load(memory_order_acquire);
+    int offset = 0;
+    uintptr_t raw;
+    do
+    {
+        raw = x->next[0].load(memory_order_acquire);
+        if (PQ_Node(raw) == tail)
+        {
+            PQ_Exit();
+            return -2;
+        }
+        if (newHead == NULL && x->inserting.load(memory_order_acquire))
+        {
+            newHead = x;    // Upper levels may still be linking, keep it
+        }
+        if (!PQ_Marked(raw))
+        {
+            raw = x->next[0].fetch_or(1, memory_order_acq_rel);
+        }
+        ++offset;
+        x = PQ_Node(raw);
+    } while (PQ_Marked(raw));
+    int key = x->key;
+    if (offset <= PQ_BOUND_OFFSET)
+    {
+        PQ_Exit();
+        return key;
+    }
+    if (newHead == NULL)
+    {
+        newHead = x;
+    }
+    if (head->next[0].compare_exchange_strong(observedHead, (uintptr_t)newHead | 1, memory_order_acq_rel))
+    {
+        Restructure();
+        node * cur = PQ_Node(observedHead);
+        while (cur != newHead)
+        {
+            node * following = PQ_Node(cur->next[0].load(memory_order_relaxed));
+            if (reclaimScheme != RECLAIM_NONE_e)
+            {
+                EBR_Retire(cur, node::Destroy);
+            }
+            cur = following;
+        }
+    }
+    PQ_Exit();
+    return key;
+}
@@ -0,0 +1,54 @@
+#ifndef SKIPLISTPQ_H
+#define SKIPLISTPQ_H
+
+#include <atomic>
+#include <limits.h>
+#include <stdint.h>
+#include "reclaim.h"
+
+using namespace std;
+
+#define PQ_MAX_LEVEL    24      // Levels of the skiplist, enough for 2^24 keys
+#define PQ_BOUND_OFFSET 32      // Deleted prefix length before it is cut off
+#define PQ_TAIL_KEY     INT_MAX // Tail sentinel, cannot be inserted
+
+/******************************************************************************
+ * Lock-Free Skiplist Priority Queue (Linden and Jonsson)
+ * A skiplist ordered by key whose smallest elements are deleted logically:
+ * a delete_min walks the bottom level from the head and claims the first
+ * node not yet taken by setting the low bit of its predecessor's next
+ * pointer with one fetch_or. Deleted nodes therefore always form a prefix
+ * of the bottom level, and inserts link new nodes after it. Only once a
+ * delete_min has walked more than PQ_BOUND_OFFSET deleted nodes does it
+ * cut the whole prefix off with a single CAS on the head, so the memory
+ * traffic of physical removal is paid once per batch rather than once per
+ * element.
+ *
+ * A search holds pointers to nodes on every level at once, more than the
+ * hazard pointer slots allow, so the queue always protects itself with
+ * epochs unless --reclaim=none.
+ *****************************************************************************/
+class skiplistpq
+{
+public:
+    struct node
+    {
+        int key;
+        int level;
+        atomic<bool> inserting;
+        atomic<uintptr_t> next[1];  // level entries allocated in line, low bit of next[0] marks the successor deleted
+        static node * Create(int k, int height);
+        static void Destroy(void * n);
+    };
+    skiplistpq();
+    ~skiplistpq();
+    void insert(int key);
+    int delete_min();
+private:
+    node * head;
+    node * tail;
+    node * LocatePreds(int key, node ** preds, node ** succs);
+    void Restructure();
+};
+
+#endif
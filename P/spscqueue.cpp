@@ -0,0 +1,129 @@
+#include "spscqueue.h"
+
+/******************************************************************************
+ * SPSC Ring
+ * Indices run freely and are masked on use, so head == tail is empty and
+ * tail - head == capacity is full.
+ *****************************************************************************/
+spscqueue::spscqueue(size_t capacity)
+{
+    size_t size = 2;
+    while (size < capacity)
+    {
+        size <<= 1;
+    }
+    buffer = new int[size];
+    mask = size - 1;
+    head.store(0, memory_order_relaxed);
+    tail.store(0, memory_order_relaxed);
+    cachedHead = 0;
+    cachedTail = 0;
+}
+
+spscqueue::~spscqueue()
+{
+    delete[] buffer;
+}
+
+size_t spscqueue::capacity()
+{
+    return mask + 1;
+}
+
+/******************************************************************************
+ * @brief spscqueue::try_push - Producer only
+ * @param val - the value being pushed
+ * @return bool - false if the ring is full
+ *****************************************************************************/
+bool spscqueue::try_push(int val)
+{
+    size_t t = tail.load(memory_order_relaxed);
+    if (t - cachedHead > mask)
+    {
+        cachedHead = head.load(memory_order_acquire);
+        if (t - cachedHead > mask)
+        {
+            return false;
+        }
+    }
+    buffer[t & mask] = val;
+    tail.store(t + 1, memory_order_release);
+    return true;
+}
+
+/******************************************************************************
+ * @brief spscqueue::try_pop - Consumer only
+ * @param val - set to the popped value
+ * @return bool - false if the ring is empty
+ *****************************************************************************/
+bool spscqueue::try_pop(int & val)
+{
+    size_t h = head.load(memory_order_relaxed);
+    if (h == cachedTail)
+    {
+        cachedTail = tail.load(memory_order_acquire);
+        if (h == cachedTail)
+        {
+            return false;
+        }
+    }
+    val = buffer[h & mask];
+    head.store(h + 1, memory_order_release);
+    return true;
+}
+
+/******************************************************************************
+ * @brief spscqueue::push_batch - Producer only. Copies as many values as fit
+ *                                and publishes them with a single store.
+ * @param vals  - the values being pushed
+ *        count - how many there are
+ * @return size_t - how many were pushed
+ *****************************************************************************/
+size_t spscqueue::push_batch(const int * vals, size_t count)
+{
+    size_t t = tail.load(memory_order_relaxed);
+    size_t room = mask + 1 - (t - cachedHead);
+    if (room < count)
+    {
+        cachedHead = head.load(memory_order_acquire);
+        room = mask + 1 - (t - cachedHead);
+    }
+    if (count > room)
+    {
+        count = room;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        buffer[(t + i) & mask] = vals[i];
+    }
+    tail.store(t + count, memory_order_release);
+    return count;
+}
+
+/******************************************************************************
+ * @brief spscqueue::pop_batch - Consumer only. Copies out up to count values
+ *                               and frees their slots with a single store.
+ * @param vals  - where the values go
+ *        count - room in vals
+ * @return size_t - how many were popped
+ *****************************************************************************/
+size_t spscqueue::pop_batch(int * vals, size_t count)
+{
+    size_t h = head.load(memory_order_relaxed);
+    size_t ready = cachedTail - h;
+    if (ready < count)
+    {
+        cachedTail = tail.load(memory_order_acquire);
+        ready = cachedTail - h;
+    }
+    if (count > ready)
+    {
+        count = ready;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        vals[i] = buffer[(h + i) & mask];
+    }
+    head.store(h + count, memory_order_release);
+    return count;
+}
@@ -0,0 +1,42 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+#include "ringqueue.h"  // CACHE_LINE
+
+using namespace std;
+
+#define SPSC_CAPACITY 4096      // Default slots, rounded up to a power of two
+
+/******************************************************************************
+ * Single Producer Single Consumer Ring
+ * Only the producer writes tail and only the consumer writes head, so both
+ * sides are wait-free with no CAS at all. Each side also keeps a cached copy
+ * of the other side's index on its own cache line and only re-reads the
+ * shared one when the cached copy says the ring is full (or empty), so in
+ * steady state the two cores do not touch each other's line per element.
+ *****************************************************************************/
+class spscqueue
+{
+public:
+    spscqueue(size_t capacity);
+    ~spscqueue();
+    bool try_push(int val);
+    bool try_pop(int & val);
+    size_t push_batch(const int * vals, size_t count);
+    size_t pop_batch(int * vals, size_t count);
+    size_t capacity();
+private:
+    int * buffer;
+    size_t mask;
+    char pad0[CACHE_LINE - sizeof(int *) - sizeof(size_t)];
+    atomic<size_t> head;    // Consumer's line
+    size_t cachedTail;
+    char pad1[CACHE_LINE - sizeof(atomic<size_t>) - sizeof(size_t)];
+    atomic<size_t> tail;    // Producer's line
+    size_t cachedHead;
+    char pad2[CACHE_LINE - sizeof(atomic<size_t>) - sizeof(size_t)];
+};
+
+#endif
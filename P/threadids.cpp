@@ -0,0 +1,144 @@
+#include "threadids.h"
+
+#include <pthread.h>
+#include <set>
+
+/******************************************************************************
+ * Every live object is in the registry under its generation, so a thread
+ * that exits after an object it used is gone only hands ids back to the
+ * ones still there. The lock is only taken when a thread meets an object
+ * for the first time, and when it exits.
+ *****************************************************************************/
+static pthread_mutex_t threadIdsLock = PTHREAD_MUTEX_INITIALIZER;
+static set<unsigned> threadIdsLive;
+static unsigned threadIdsGeneration = 0;    // Guarded by threadIdsLock
+
+struct threadids_held
+{
+    unsigned generation;
+    threadids * owner;
+    int id;
+};
+
+struct threadids_owner
+{
+    vector<threadids_held> held;
+    unsigned lastGeneration;    // The object used last, skips the table
+    int lastId;
+    threadids_owner() : lastGeneration(0), lastId(-1) {}
+    ~threadids_owner()
+    {
+        pthread_mutex_lock(&threadIdsLock);
+        for (size_t i = 0; i < held.size(); ++i)
+        {
+            if (threadIdsLive.count(held[i].generation) != 0)
+            {
+                held[i].owner->Release(held[i].id);
+            }
+        }
+        pthread_mutex_unlock(&threadIdsLock);
+    }
+};
+static thread_local threadids_owner threadIdsOwner;
+
+threadids::threadids(int maxIds) : max(maxIds), next(0)
+{
+    pthread_mutex_lock(&threadIdsLock);
+    generation = ++threadIdsGeneration;
+    threadIdsLive.insert(generation);
+    pthread_mutex_unlock(&threadIdsLock);
+}
+
+threadids::~threadids()
+{
+    pthread_mutex_lock(&threadIdsLock);
+    threadIdsLive.erase(generation);
+    pthread_mutex_unlock(&threadIdsLock);
+}
+
+/******************************************************************************
+ * @brief threadids::mine - Returns the id the calling thread holds on this
+ *                          object, taking one on first use
+ * @param none
+ * @return int - the id, -1 if max threads alive hold one already
+ *****************************************************************************/
+int threadids::mine()
+{
+    threadids_owner & o = threadIdsOwner;
+    if (o.lastGeneration == generation)
+    {
+        return o.lastId;
+    }
+    int id = -1;
+    for (size_t i = 0; i < o.held.size(); ++i)
+    {
+        if (o.held[i].generation == generation)
+        {
+            id = o.held[i].id;
+            break;
+        }
+    }
+    if (id < 0)
+    {
+        id = Acquire();
+    }
+    // A thread left without an id tries again when it comes back from
+    // another object, some other thread may have exited by then
+    o.lastGeneration = generation;
+    o.lastId = id;
+    return id;
+}
+
+int threadids::count()
+{
+    int n = next.load(memory_order_acquire);
+    return (n < max) ? n : max;
+}
+
+/******************************************************************************
+ * @brief threadids::Acquire - Takes a freed id, or a new one while there are
+ *                             any left, and drops the caller's ids on
+ *                             objects that are gone
+ * @param none
+ * @return int - the id, -1 if there is none
+ *****************************************************************************/
+int threadids::Acquire()
+{
+    threadids_owner & o = threadIdsOwner;
+    pthread_mutex_lock(&threadIdsLock);
+    size_t kept = 0;
+    for (size_t i = 0; i < o.held.size(); ++i)
+    {
+        if (threadIdsLive.count(o.held[i].generation) != 0)
+        {
+            o.held[kept++] = o.held[i];
+        }
+    }
+    o.held.resize(kept);
+    int id = -1;
+    if (!freeIds.empty())
+    {
+        id = freeIds.back();
+        freeIds.pop_back();
+    }
+    else if (next.load(memory_order_relaxed) < max)
+    {
+        id = next.fetch_add(1, memory_order_release);
+    }
+    if (id >= 0)
+    {
+        threadids_held h = {generation, this, id};
+        o.held.push_back(h);
+    }
+    pthread_mutex_unlock(&threadIdsLock);
+    return id;
+}
+
+/******************************************************************************
+ * @brief threadids::Release - Puts an exiting thread's id on the free list.
+ *                             Registry lock must be held.
+ *****************************************************************************/
+void threadids::Release(int id)
+{
+    freeIds.push_back(id);
+}
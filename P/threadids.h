@@ -0,0 +1,38 @@
+#ifndef THREADIDS_H
+#define THREADIDS_H
+
+#include <atomic>
+#include <vector>
+
+using namespace std;
+
+/******************************************************************************
+ * Per-Object Thread Ids
+ * The elimination stack and the wait-free queue keep one slot per thread in
+ * a fixed array, so a thread needs an index into every such object it uses.
+ * A thread keeps the ids it holds in a thread-local table keyed by the
+ * object's generation, so going back and forth between objects finds the
+ * same id again instead of taking another. When the thread exits its ids
+ * go back on each object's free list, and later threads take one from
+ * there before a new one is handed out, so only threads alive at the same
+ * time compete for the max ids. The generation tells a new object at a
+ * recycled address apart from the old one.
+ *****************************************************************************/
+class threadids
+{
+public:
+    threadids(int maxIds);
+    ~threadids();
+    int mine();     // The caller's id, -1 while max other threads hold one
+    int count();    // Ids handed out so far, never more than max
+private:
+    unsigned generation;
+    int max;
+    atomic<int> next;
+    vector<int> freeIds;    // Guarded by the registry lock
+    int Acquire();
+    void Release(int id);
+    friend struct threadids_owner;
+};
+
+#endif
@@ -0,0 +1,172 @@
+#ifndef TLCACHE_H
+#define TLCACHE_H
+
+#include <atomic>
+#include <stdio.h>
+#include <string.h>
+#include "treiberstack.h"
+
+using namespace std;
+
+#define TLC_STALENESS 256   // Default --staleness, operations an element may stay local
+
+/******************************************************************************
+ * Thread-Local Elimination Cache
+ * A small private stack a thread keeps in front of a shared one. push lands
+ * in the cache and a pop is served from it whenever it has anything, so a
+ * push followed by a pop on the same thread never touches the shared top.
+ * When the cache is full its older half goes to the shared stack in one
+ * batch (a single CAS on a tstack), keeping the newest elements local, and a
+ * pop that finds it empty goes to the shared stack.
+ *
+ * Elements in a cache are invisible to every other thread, which is the
+ * price. staleness bounds it: an element still local after that many of the
+ * thread's own operations is spilled, along with anything older. A cache is
+ * made on the stack of the thread that uses it and flushes everything back
+ * when it goes out of scope. Its counts are added to stats there.
+ *****************************************************************************/
+struct tlcache_stats
+{
+    atomic<unsigned long long> hits;        // Pops served locally
+    atomic<unsigned long long> misses;      // Pops that went to the shared stack
+    atomic<unsigned long long> spills;      // Batches handed to the shared stack
+    atomic<unsigned long long> spilled;     // Elements in them
+    tlcache_stats() : hits(0), misses(0), spills(0), spilled(0) {}
+    void report()
+    {
+        unsigned long long h = hits.load();
+        unsigned long long m = misses.load();
+        printf("TL cache hits: %llu misses: %llu hit rate: %.2f%% spills: %llu (%llu elements)\n",
+               h, m, (h + m == 0) ? 0.0 : 100.0 * h / (h + m), spills.load(), spilled.load());
+    }
+};
+
+/******************************************************************************
+ * @brief TLC_Spill - Pushes vals[0..count) onto the shared stack, vals[0]
+ *                    first. A tstack takes them with one push_batch.
+ *****************************************************************************/
+template <class S>
+static inline void TLC_Spill(S * shared, const int * vals, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        shared->push(vals[i]);
+    }
+}
+
+template <class P>
+static inline void TLC_Spill(basic_tstack<P> * shared, const int * vals, size_t count)
+{
+    shared->push_batch(vals, count);
+}
+
+template <class S>
+class tlcache
+{
+public:
+    /**************************************************************************
+     * @param stack     - the shared stack
+     *        capacity  - elements kept locally, 0 passes everything through
+     *        staleness - operations of this thread an element may stay local
+     *        stats     - where the counts go on destruction, may be NULL
+     *************************************************************************/
+    tlcache(S * stack, size_t capacity, size_t staleness, tlcache_stats * stats = NULL)
+        : shared(stack), cap(capacity), count(0), maxAge(staleness), ops(0),
+          hits(0), misses(0), spills(0), spilled(0), totals(stats)
+    {
+        vals = new int[cap + 1];
+        stamps = new unsigned long long[cap + 1];
+    }
+    ~tlcache()
+    {
+        flush();
+        if (totals != NULL)
+        {
+            totals->hits += hits;
+            totals->misses += misses;
+            totals->spills += spills;
+            totals->spilled += spilled;
+        }
+        delete[] vals;
+        delete[] stamps;
+    }
+    void push(int val)
+    {
+        ++ops;
+        if (cap == 0)
+        {
+            shared->push(val);
+            return;
+        }
+        if (count == cap)
+        {
+            Spill(count - count / 2);
+        }
+        vals[count] = val;
+        stamps[count] = ops;
+        ++count;
+        Age();
+    }
+    /**************************************************************************
+     * @return int - the newest local value, else the shared stack's top,
+     *               -2 if both are empty
+     *************************************************************************/
+    int pop()
+    {
+        ++ops;
+        if (count > 0)
+        {
+            ++hits;
+            int val = vals[--count];
+            Age();
+            return val;
+        }
+        ++misses;
+        return shared->pop();
+    }
+    void flush()
+    {
+        Spill(count);
+    }
+private:
+    S * shared;
+    int * vals;                     // vals[count - 1] is the local top
+    unsigned long long * stamps;    // ops when each was pushed
+    size_t cap;
+    size_t count;
+    size_t maxAge;
+    unsigned long long ops;
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long spills;
+    unsigned long long spilled;
+    tlcache_stats * totals;
+    /**************************************************************************
+     * @brief Spill - Hands the oldest n elements to the shared stack in one
+     *                batch and slides the rest down
+     *************************************************************************/
+    void Spill(size_t n)
+    {
+        if (n == 0)
+        {
+            return;
+        }
+        TLC_Spill(shared, vals, n);
+        ++spills;
+        spilled += n;
+        count -= n;
+        memmove(vals, vals + n, count * sizeof(int));
+        memmove(stamps, stamps + n, count * sizeof(unsigned long long));
+    }
+    void Age()
+    {
+        size_t n = 0;
+        while (n < count && ops - stamps[n] > maxAge)
+        {
+            ++n;
+        }
+        Spill(n);
+    }
+};
+
+#endif
@@ -3,11 +3,33 @@
  * Treiber Stack
  * Credit goes to Joe Izraelevitz - Concurrent Programming Class Lecture Notes
  *****************************************************************************/ 
+template <class P>
+basic_tstack<P>::basic_tstack()
+{
+    top.store(NULL);
+}
+
+/******************************************************************************
+ * @brief tstack::~tstack - Frees whatever is left. Popped nodes are owned by
+ *                          the reclamation retire lists, not by the stack.
+ *****************************************************************************/ 
+template <class P>
+basic_tstack<P>::~basic_tstack()
+{
+    node * t = top.load(memory_order_relaxed);
+    while (t != NULL)
+    {
+        node * down = t->down;
+        delete t;
+        t = down;
+    }
+}
 
-void tstack::print()
+template <class P>
+void basic_tstack<P>::print()
 {
-    node * t = top.load(memory_order_acquire);
-    while(t->val != -2)
+    node * t = top.load(P::load);
+    while(t != NULL && t->val != -2)
     {
         printf("%d ", t->val);
         t = t->down;
@@ -15,31 +37,179 @@ void tstack::print()
     printf("\n");
 }
 
-void tstack::push(int val)
+template <class P>
+void basic_tstack<P>::push(int val)
 {
     node * n = new node(val);
     node * t;
-    do 
+    backoff b;
+    while (true)
     {
-        t = top.load(memory_order_acquire);
+        t = top.load(P::load);
         n->down = t;
-    } while (!top.compare_exchange_weak(t,n,memory_order_acq_rel));
+        if (top.compare_exchange_weak(t, n, P::cas, P::casFail))
+        {
+            break;
+        }
+        b.pause();
+    }
     // printf("Treiber-Push:%d\n", val);
 }
-int tstack::pop()
+template <class P>
+int basic_tstack<P>::pop()
 {
     node * t;
     node * n;
     int v = 0;
-    do
+    backoff b;
+    Reclaim_Enter();
+    while (true)
     {
-        t = top.load(memory_order_acquire);
+        t = Reclaim_Protect(0, top);   // t->down must not be freed under us
         if (t == NULL)
         {
+            Reclaim_Exit();
             return -2;
         }
         n = t->down;
         v = t->val;
-    } while (!top.compare_exchange_weak(t,n,memory_order_acq_rel));
+        if (top.compare_exchange_weak(t, n, P::cas, P::casFail))
+        {
+            break;
+        }
+        b.pause();
+    }
+    Reclaim_Exit();
+    Reclaim_Retire(t);
     return v;
 }
+
+/******************************************************************************
+ * @brief tstack::push_batch - Links the values into a private chain and
+ *                             publishes all of it with one CAS on top. The
+ *                             stack ends up as if they were pushed in order.
+ * @param vals  - the values, vals[count - 1] ends up on top
+ *        count - how many
+ * @return none
+ *****************************************************************************/
+template <class P>
+void basic_tstack<P>::push_batch(const int * vals, size_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    node * bottom = new node(vals[0]);
+    node * first = bottom;
+    for (size_t i = 1; i < count; ++i)
+    {
+        node * n = new node(vals[i]);
+        n->down = first;
+        first = n;
+    }
+    node * t;
+    backoff b;
+    while (true)
+    {
+        t = top.load(P::load);
+        bottom->down = t;
+        if (top.compare_exchange_weak(t, first, P::cas, P::casFail))
+        {
+            break;
+        }
+        b.pause();
+    }
+}
+
+/******************************************************************************
+ * @brief tstack::pop_batch - Pops up to count values with one CAS on top.
+ *                            While top is still t nothing below it can have
+ *                            been popped, so each step down is protected
+ *                            hand over hand (slots 1 and 2) and checked
+ *                            against top.
+ * @param vals  - where the values go, topmost first
+ *        count - room in vals
+ * @return size_t - how many were popped, 0 if the stack is empty
+ *****************************************************************************/
+template <class P>
+size_t basic_tstack<P>::pop_batch(int * vals, size_t count)
+{
+    node * t;
+    node * last;
+    size_t taken;
+    backoff b;
+    if (count == 0)
+    {
+        return 0;
+    }
+    Reclaim_Enter();
+    while (true)
+    {
+        t = Reclaim_Protect(0, top);
+        if (t == NULL)
+        {
+            Reclaim_Exit();
+            return 0;
+        }
+        last = t;
+        vals[0] = t->val;
+        for (taken = 1; taken < count; ++taken)
+        {
+            node * n = last->down;
+            if (n == NULL)
+            {
+                break;
+            }
+            Reclaim_Publish(1 + (taken & 1), n);
+            if (top.load(P::load) != t)
+            {
+                break;
+            }
+            vals[taken] = n->val;
+            last = n;
+        }
+        if (top.compare_exchange_weak(t, last->down, P::cas, P::casFail))
+        {
+            break;
+        }
+        b.pause();
+    }
+    Reclaim_Exit();
+    for (size_t i = 0; i < taken; ++i)
+    {
+        node * down = t->down;
+        Reclaim_Retire(t);
+        t = down;
+    }
+    return taken;
+}
+
+/******************************************************************************
+ * @brief tstack::pop_all - Empties the stack with one exchange on top
+ * @param vals - the values get appended here topmost first, NULL drops them
+ * @return size_t - how many were popped
+ *****************************************************************************/
+template <class P>
+size_t basic_tstack<P>::pop_all(vector<int> * vals)
+{
+    node * t = top.exchange(NULL, P::cas);
+    size_t taken = 0;
+    while (t != NULL)
+    {
+        node * down = t->down;
+        if (vals != NULL)
+        {
+            vals->push_back(t->val);
+        }
+        Reclaim_Retire(t);  // Poppers that lost the race may still hold it
+        t = down;
+        ++taken;
+    }
+    return taken;
+}
+
+// Every policy --policy can pick
+template class basic_tstack<seqcst_policy>;
+template class basic_tstack<acqrel_policy>;
+template class basic_tstack<seqcst_padded_policy>;
+template class basic_tstack<acqrel_padded_policy>;
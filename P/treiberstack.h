@@ -3,24 +3,37 @@
 
 #include <atomic>
 #include <iostream>
+#include <vector>
+#include "reclaim.h"
+#include "pool.h"
+#include "policy.h"
+#include "backoff.h"
 
 using namespace std;
 
 
-class tstack
+template <class P>
+class basic_tstack
 {
 public:
-    class node 
+    class alignas(P::nodeAlign) node : public pooled
     {
     public:
         node (int v):val(v){}
         int val;
         node * down;
     };
-    atomic<node *> top;
+    alignas(P::align) atomic<node *> top;
+    basic_tstack();
+    ~basic_tstack();
     void push(int val);
     int pop();
+    void push_batch(const int * vals, size_t count);
+    size_t pop_batch(int * vals, size_t count);
+    size_t pop_all(vector<int> * vals);
     void print();
 };
 
+typedef basic_tstack<acqrel_policy> tstack;
+
 #endif
\ No newline at end of file
@@ -0,0 +1,251 @@
+#ifndef TYPED_H
+#define TYPED_H
+
+#include <atomic>
+#include <new>          // placement new
+#include <utility>      // move, forward
+#include "reclaim.h"
+#include "pool.h"
+#include "policy.h"
+#include "backoff.h"
+
+using namespace std;
+
+/******************************************************************************
+ * Typed Treiber Stack and Michael and Scott Queue
+ * The same algorithms as basic_tstack and basic_msqueue for any payload T,
+ * move-only and large ones included. Values are constructed in place in
+ * the node (emplace), so nothing is boxed, and are moved out only by the
+ * thread whose CAS took the node, so no other thread ever touches a T.
+ * Emptiness is the bool result of try_pop/try_dequeue rather than a -2
+ * sentinel, as C++11 has no optional. T lives in raw storage inside the
+ * node: a node's T is destroyed as soon as it is moved out, while the node
+ * itself waits for the reclamation scheme because other threads may still
+ * be reading its links, and the queue's dummy holds no T at all. These are
+ * templates over T, so unlike basic_tstack/basic_msqueue they live entirely
+ * in this header.
+ *****************************************************************************/
+template <class T, class P = acqrel_policy>
+class typed_tstack
+{
+public:
+    class alignas(P::nodeAlign) node : public pooled
+    {
+    public:
+        alignas(T) unsigned char storage[sizeof(T)];
+        node * down;
+        T * value() { return (T *)storage; }
+    };
+    alignas(P::align) atomic<node *> top;
+
+    typed_tstack()
+    {
+        top.store(NULL);
+    }
+
+    /**************************************************************************
+     * @brief typed_tstack::~typed_tstack - Destroys and frees what is left
+     *************************************************************************/
+    ~typed_tstack()
+    {
+        node * t = top.load(memory_order_relaxed);
+        while (t != NULL)
+        {
+            node * down = t->down;
+            t->value()->~T();
+            delete t;
+            t = down;
+        }
+    }
+
+    /**************************************************************************
+     * @brief typed_tstack::emplace - Constructs a T from args in a new node
+     *                                and pushes it
+     * @param args - T's constructor arguments
+     * @return none
+     *************************************************************************/
+    template <class... Args>
+    void emplace(Args &&... args)
+    {
+        node * n = new node;
+        new (n->storage) T(std::forward<Args>(args)...);
+        node * t;
+        backoff b;
+        while (true)
+        {
+            t = top.load(P::load);
+            n->down = t;
+            if (top.compare_exchange_weak(t, n, P::cas, P::casFail))
+            {
+                break;
+            }
+            b.pause();
+        }
+    }
+
+    void push(T && val)
+    {
+        emplace(std::move(val));
+    }
+
+    /**************************************************************************
+     * @brief typed_tstack::try_pop - Moves the top value into out
+     * @param out - assigned the value
+     * @return bool - false if the stack was empty, out is then untouched
+     *************************************************************************/
+    bool try_pop(T & out)
+    {
+        node * t;
+        backoff b;
+        Reclaim_Enter();
+        while (true)
+        {
+            t = Reclaim_Protect(0, top);   // t->down must not be freed under us
+            if (t == NULL)
+            {
+                Reclaim_Exit();
+                return false;
+            }
+            if (top.compare_exchange_weak(t, t->down, P::cas, P::casFail))
+            {
+                break;
+            }
+            b.pause();
+        }
+        Reclaim_Exit();
+        out = std::move(*t->value());   // Only the winner gets here
+        t->value()->~T();
+        Reclaim_Retire(t);
+        return true;
+    }
+};
+
+template <class T, class P = seqcst_policy>
+class typed_msqueue
+{
+public:
+    class alignas(P::nodeAlign) node : public pooled
+    {
+    public:
+        node() : next(NULL) {}
+        alignas(T) unsigned char storage[sizeof(T)];
+        atomic<node *> next;
+        T * value() { return (T *)storage; }
+    };
+    alignas(P::align) atomic<node *> head;
+    alignas(P::align) atomic<node *> tail;
+
+    typed_msqueue()
+    {
+        node * dummy = new node;
+        head.store(dummy);
+        tail.store(dummy);
+    }
+
+    /**************************************************************************
+     * @brief typed_msqueue::~typed_msqueue - Destroys the values still
+     *                                        queued and frees every node
+     *************************************************************************/
+    ~typed_msqueue()
+    {
+        node * h = head.load(memory_order_relaxed);
+        node * n = h->next.load(memory_order_relaxed);
+        delete h;   // The dummy, no value
+        while (n != NULL)
+        {
+            node * following = n->next.load(memory_order_relaxed);
+            n->value()->~T();
+            delete n;
+            n = following;
+        }
+    }
+
+    /**************************************************************************
+     * @brief typed_msqueue::emplace - Constructs a T from args in a new node
+     *                                 and enqueues it
+     * @param args - T's constructor arguments
+     * @return none
+     *************************************************************************/
+    template <class... Args>
+    void emplace(Args &&... args)
+    {
+        node * n = new node;
+        new (n->storage) T(std::forward<Args>(args)...);
+        node * t;
+        node * e;
+        backoff b;
+        Reclaim_Enter();
+        while (true)
+        {
+            t = Reclaim_Protect(0, tail);
+            e = t->next.load(P::load);
+            if (t == tail.load(P::load))
+            {
+                node * expected = NULL;
+                if (e == NULL && t->next.compare_exchange_weak(expected, n, P::cas, P::casFail))
+                {
+                    break;
+                }
+                if (e != NULL)
+                {
+                    tail.compare_exchange_weak(t, e, P::cas, P::casFail);
+                }
+            }
+            b.pause();
+        }
+        tail.compare_exchange_weak(t, n, P::cas, P::casFail);
+        Reclaim_Exit();
+    }
+
+    void enqueue(T && val)
+    {
+        emplace(std::move(val));
+    }
+
+    /**************************************************************************
+     * @brief typed_msqueue::try_dequeue - Moves the oldest value into out.
+     *                                     Its node becomes the dummy, so the
+     *                                     value is destroyed there and then.
+     * @param out - assigned the value
+     * @return bool - false if the queue was empty, out is then untouched
+     *************************************************************************/
+    bool try_dequeue(T & out)
+    {
+        node * t;
+        node * h;
+        node * n;
+        backoff b;
+        Reclaim_Enter();
+        while (true)
+        {
+            h = Reclaim_Protect(0, head);
+            t = tail.load(P::load);
+            n = Reclaim_Protect(1, h->next);
+            if (h != head.load(P::load))
+            {
+                continue;   // h was dequeued, n may already be retired
+            }
+            if (h == t)
+            {
+                if (n == NULL)
+                {
+                    Reclaim_Exit();
+                    return false;
+                }
+                tail.compare_exchange_weak(t, n, P::cas, P::casFail);
+            }
+            else if (head.compare_exchange_weak(h, n, P::cas, P::casFail))
+            {
+                break;
+            }
+            b.pause();
+        }
+        out = std::move(*n->value());   // Still in slot 1
+        n->value()->~T();
+        Reclaim_Exit();
+        Reclaim_Retire(h);
+        return true;
+    }
+};
+
+#endif
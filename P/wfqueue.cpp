@@ -0,0 +1,481 @@
+#include "wfqueue.h"
+
+/******************************************************************************
+ * Wait-Free Queue
+ * Credit goes to Alex Kogan and Erez Petrank - "Wait-Free Queues With
+ * Multiple Enqueuers and Dequeuers" (PPoPP 2011) and "A Methodology for
+ * Creating Fast Wait-Free Data Structures" (PPoPP 2012)
+ *****************************************************************************/
+
+/******************************************************************************
+ * Where a fast path thread is in its round of looking at the others, across
+ * every queue it uses.
+ *****************************************************************************/
+struct wfq_help
+{
+    unsigned long operations;
+    unsigned helpCursor;
+};
+static thread_local wfq_help wfqHelp = {0, 0};
+
+wfqueue::wfqueue(int fastPathAttempts) : ids(WFQ_MAX_THREADS)
+{
+    fastAttempts = (fastPathAttempts < 0) ? 0 : fastPathAttempts;
+    node * dummy = new node(DUMMY, WFQ_FAST);
+    head.store(dummy);
+    tail.store(dummy);
+    for (int id = 0; id < WFQ_MAX_THREADS; ++id)
+    {
+        state[id].store(NULL);
+    }
+    phaseCounter.store(0);
+    maxEnqRetries.store(0);
+    maxDeqRetries.store(0);
+    slowOps.store(0);
+}
+
+/******************************************************************************
+ * @brief wfqueue::~wfqueue - Frees the dummy, anything not dequeued and the
+ *                            descriptors still announced
+ *****************************************************************************/
+wfqueue::~wfqueue()
+{
+    node * h = head.load();
+    while (h != NULL)
+    {
+        node * n = h->next.load();
+        delete h;
+        h = n;
+    }
+    for (int id = 0; id < WFQ_MAX_THREADS; ++id)
+    {
+        delete state[id].load();
+    }
+}
+
+int wfqueue::MyId()
+{
+    int id = ids.mine();
+    return (id < 0) ? WFQ_NONE : id;
+}
+
+int wfqueue::Threads()
+{
+    return ids.count();
+}
+
+void wfqueue::report()
+{
+    printf("Max retries: enqueue %lu dequeue %lu slow path ops: %lu\n",
+           maxEnqRetries.load(), maxDeqRetries.load(), slowOps.load());
+}
+
+/******************************************************************************
+ * @brief wfqueue::Pending - Protects tid's descriptor in slot 2
+ * @param tid - the announcing thread
+ *        ph  - the helper's phase
+ * @return desc * - the descriptor if its operation is pending with a phase
+ *                  no newer than ph, NULL otherwise
+ *****************************************************************************/
+wfqueue::desc * wfqueue::Pending(int tid, long ph)
+{
+    desc * d = Reclaim_Protect(2, state[tid]);
+    if (d != NULL && d->pending && d->phase <= ph)
+    {
+        return d;
+    }
+    return NULL;
+}
+
+/******************************************************************************
+ * @brief wfqueue::HelpOthers - Every WFQ_HELP_DELAY operations, finishes
+ *                              the next thread's announced operation if any
+ * @param tid - the calling thread
+ * @return none
+ *****************************************************************************/
+void wfqueue::HelpOthers(int tid)
+{
+    if (tid == WFQ_NONE || ++wfqHelp.operations % WFQ_HELP_DELAY != 0)
+    {
+        return;
+    }
+    int other = (int)(wfqHelp.helpCursor++ % (unsigned)Threads());
+    desc * d = Reclaim_Protect(2, state[other]);
+    if (d != NULL && d->pending)
+    {
+        unsigned long ignored = 0;
+        if (d->enqueue)
+        {
+            HelpEnq(other, d->phase, ignored);
+        }
+        else
+        {
+            HelpDeq(other, d->phase, ignored);
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief wfqueue::Help - Completes every announced operation of phase ph or
+ *                        older, the caller's own included
+ * @param ph      - the caller's phase
+ *        retries - incremented per step taken
+ * @return none
+ *****************************************************************************/
+void wfqueue::Help(long ph, unsigned long & retries)
+{
+    int threads = Threads();
+    for (int i = 0; i < threads; ++i)
+    {
+        desc * d = Pending(i, ph);
+        if (d == NULL)
+        {
+            continue;
+        }
+        if (d->enqueue)
+        {
+            HelpEnq(i, ph, retries);
+        }
+        else
+        {
+            HelpDeq(i, ph, retries);
+        }
+    }
+}
+
+void wfqueue::HelpEnq(int tid, long ph, unsigned long & retries)
+{
+    while (Pending(tid, ph) != NULL)
+    {
+        ++retries;
+        node * last = Reclaim_Protect(0, tail);
+        node * next = last->next.load();
+        if (last != tail.load())
+        {
+            continue;
+        }
+        if (next == NULL)
+        {
+            desc * d = Pending(tid, ph);
+            node * expected = NULL;
+            if (d != NULL && last->next.compare_exchange_strong(expected, d->target))
+            {
+                HelpFinishEnq();
+                return;
+            }
+        }
+        else
+        {
+            HelpFinishEnq();    // Somebody else's node, move tail past it first
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief wfqueue::HelpFinishEnq - Marks the enqueue of the node after tail
+ *                                 complete, then swings tail to it
+ *****************************************************************************/
+void wfqueue::HelpFinishEnq()
+{
+    node * last = Reclaim_Protect(0, tail);
+    node * next = last->next.load();
+    if (next == NULL)
+    {
+        return;
+    }
+    Reclaim_Publish(1, next);
+    if (last != tail.load())
+    {
+        return;     // next may have been dequeued since
+    }
+    int tid = next->enqTid;
+    if (tid >= 0)
+    {
+        desc * cur = Reclaim_Protect(2, state[tid]);
+        if (last == tail.load() && cur->pending && cur->target == next)
+        {
+            desc * done = new desc(cur->phase, false, true, next, 0);
+            if (state[tid].compare_exchange_strong(cur, done))
+            {
+                Reclaim_Retire(cur);
+            }
+            else
+            {
+                delete done;
+            }
+        }
+    }
+    tail.compare_exchange_strong(last, next);
+}
+
+void wfqueue::HelpDeq(int tid, long ph, unsigned long & retries)
+{
+    while (true)
+    {
+        desc * cur = Pending(tid, ph);
+        if (cur == NULL)
+        {
+            return;
+        }
+        ++retries;
+        node * first = Reclaim_Protect(0, head);
+        node * last = tail.load();
+        node * next = first->next.load();
+        if (first != head.load())
+        {
+            continue;
+        }
+        if (first == last)
+        {
+            if (next == NULL)
+            {
+                // Empty, complete the dequeue with nothing
+                if (last == tail.load())
+                {
+                    desc * done = new desc(cur->phase, false, false, NULL, -2);
+                    if (state[tid].compare_exchange_strong(cur, done))
+                    {
+                        Reclaim_Retire(cur);
+                    }
+                    else
+                    {
+                        delete done;
+                    }
+                }
+            }
+            else
+            {
+                HelpFinishEnq();
+            }
+            continue;
+        }
+        if (cur->target != first)
+        {
+            // Point the descriptor at the current dummy before claiming it
+            desc * claim = new desc(cur->phase, true, false, first, 0);
+            if (!state[tid].compare_exchange_strong(cur, claim))
+            {
+                delete claim;
+                continue;
+            }
+            Reclaim_Retire(cur);
+        }
+        int none = WFQ_NONE;
+        first->deqTid.compare_exchange_strong(none, tid);
+        HelpFinishDeq();
+    }
+}
+
+/******************************************************************************
+ * @brief wfqueue::HelpFinishDeq - Completes the dequeue that claimed the
+ *                                 dummy at head, then swings head past it
+ *****************************************************************************/
+void wfqueue::HelpFinishDeq()
+{
+    node * first = Reclaim_Protect(0, head);
+    node * next = first->next.load();
+    Reclaim_Publish(1, next);
+    if (first != head.load())
+    {
+        return;     // next may have been dequeued since
+    }
+    int tid = first->deqTid.load();
+    if (tid == WFQ_NONE || next == NULL)
+    {
+        return;
+    }
+    if (tid >= 0)
+    {
+        desc * cur = Reclaim_Protect(2, state[tid]);
+        if (first == head.load() && cur->pending)
+        {
+            desc * done = new desc(cur->phase, false, false, cur->target, next->val);
+            if (state[tid].compare_exchange_strong(cur, done))
+            {
+                Reclaim_Retire(cur);
+            }
+            else
+            {
+                delete done;
+            }
+        }
+    }
+    head.compare_exchange_strong(first, next);
+}
+
+/******************************************************************************
+ * @brief wfqueue::FastEnqueue - The M&S enqueue, giving up after attempts
+ *                               tries
+ * @param n        - the node, enqTid WFQ_FAST
+ *        retries  - incremented per failed attempt
+ *        attempts - how many tries, 0 gives up straight away
+ * @return bool - whether n was linked
+ *****************************************************************************/
+bool wfqueue::FastEnqueue(node * n, unsigned long & retries, int attempts)
+{
+    backoff b;
+    for (int attempt = 0; attempt < attempts; ++attempt)
+    {
+        if (attempt > 0)
+        {
+            ++retries;
+            b.pause();
+        }
+        node * last = Reclaim_Protect(0, tail);
+        node * next = last->next.load();
+        if (last != tail.load())
+        {
+            continue;
+        }
+        if (next == NULL)
+        {
+            if (last->next.compare_exchange_strong(next, n))
+            {
+                tail.compare_exchange_strong(last, n);
+                return true;
+            }
+        }
+        else
+        {
+            HelpFinishEnq();
+        }
+    }
+    return false;
+}
+
+/******************************************************************************
+ * @brief wfqueue::FastDequeue - The M&S dequeue, claiming the dummy with
+ *                               WFQ_FAST first so a slow path helper cannot
+ *                               take it too
+ * @param val      - set to the value, -2 if the queue is empty
+ *        retries  - incremented per failed attempt
+ *        attempts - how many tries, 0 gives up straight away
+ * @return bool - whether the dequeue happened
+ *****************************************************************************/
+bool wfqueue::FastDequeue(int & val, unsigned long & retries, int attempts)
+{
+    backoff b;
+    for (int attempt = 0; attempt < attempts; ++attempt)
+    {
+        if (attempt > 0)
+        {
+            ++retries;
+            b.pause();
+        }
+        node * first = Reclaim_Protect(0, head);
+        node * last = tail.load();
+        node * next = Reclaim_Protect(1, first->next);
+        if (first != head.load())
+        {
+            continue;
+        }
+        if (first == last)
+        {
+            if (next == NULL)
+            {
+                val = -2;
+                return true;
+            }
+            HelpFinishEnq();
+            continue;
+        }
+        int none = WFQ_NONE;
+        if (first->deqTid.compare_exchange_strong(none, WFQ_FAST))
+        {
+            val = next->val;
+            HelpFinishDeq();
+            Reclaim_Retire(first);  // head has moved past it
+            return true;
+        }
+        HelpFinishDeq();    // Somebody else claimed it, move head along
+    }
+    return false;
+}
+
+/******************************************************************************
+ * @brief wfqueue::enqueue - Fast path first, then announces the enqueue and
+ *                           helps until it is done
+ * @param val - the value being enqueued
+ * @return none
+ *****************************************************************************/
+void wfqueue::enqueue(int val)
+{
+    int tid = MyId();
+    unsigned long retries = 0;
+    Reclaim_Enter();
+    HelpOthers(tid);
+    node * n = new node(val, WFQ_FAST);
+    if (!FastEnqueue(n, retries, fastAttempts))
+    {
+        if (tid == WFQ_NONE)
+        {
+            while (!FastEnqueue(n, retries, WFQ_MAX_FAILURES))
+            {
+                // No slot to announce in, stay lock-free
+            }
+        }
+        else
+        {
+            n->enqTid = tid;    // Not linked yet, nobody else sees it
+            // A helper may finish and retire d as soon as it is published
+            long phase = ++phaseCounter;
+            desc * old = state[tid].exchange(new desc(phase, true, true, n, 0));
+            if (old != NULL)
+            {
+                Reclaim_Retire(old);
+            }
+            Help(phase, retries);
+            HelpFinishEnq();
+            ++slowOps;
+        }
+    }
+    Reclaim_Exit();
+    Retry_Max(maxEnqRetries, retries);
+}
+
+/******************************************************************************
+ * @brief wfqueue::dequeue - Fast path first, then announces the dequeue and
+ *                           helps until it is done
+ * @param None
+ * @return int - the value or -2 == EMPTY
+ *****************************************************************************/
+int wfqueue::dequeue()
+{
+    int tid = MyId();
+    unsigned long retries = 0;
+    int val;
+    Reclaim_Enter();
+    HelpOthers(tid);
+    if (!FastDequeue(val, retries, fastAttempts))
+    {
+        if (tid == WFQ_NONE)
+        {
+            while (!FastDequeue(val, retries, WFQ_MAX_FAILURES))
+            {
+                // No slot to announce in, stay lock-free
+            }
+        }
+        else
+        {
+            long phase = ++phaseCounter;
+            desc * old = state[tid].exchange(new desc(phase, true, false, NULL, 0));
+            if (old != NULL)
+            {
+                Reclaim_Retire(old);
+            }
+            Help(phase, retries);
+            HelpFinishDeq();
+            // Nobody but the owner replaces a finished descriptor
+            desc * d = state[tid].load();
+            val = d->val;
+            if (d->target != NULL)
+            {
+                Reclaim_Retire(d->target);  // head has moved past it
+            }
+            ++slowOps;
+        }
+    }
+    Reclaim_Exit();
+    Retry_Max(maxDeqRetries, retries);
+    return val;
+}
@@ -0,0 +1,91 @@
+#ifndef WFQUEUE_H
+#define WFQUEUE_H
+
+#include <atomic>
+#include <stdio.h>
+#include "msqueue.h"    // Retry_Max
+#include "ringqueue.h"  // CACHE_LINE
+#include "reclaim.h"
+#include "pool.h"
+#include "backoff.h"
+#include "threadids.h"
+
+using namespace std;
+
+#define WFQ_MAX_THREADS  256    // Threads alive at once past this only get the fast path
+#define WFQ_MAX_FAILURES 8      // Fast path attempts before asking for help
+#define WFQ_HELP_DELAY   16     // Operations between looks at another thread
+#define WFQ_NONE         -1     // deqTid: not dequeued yet
+#define WFQ_FAST         -2     // enqTid/deqTid: linked/taken by a fast path
+
+/******************************************************************************
+ * Wait-Free Queue (Kogan and Petrank, fast-path/slow-path)
+ * Every operation first tries the plain M&S algorithm WFQ_MAX_FAILURES
+ * times. A thread that keeps losing announces its operation in state[] with
+ * a phase number and from then on every thread helps all announced
+ * operations of an older or equal phase before its own, so a slow path
+ * completes after a bounded number of steps however the others are
+ * scheduled. A dequeue claims its dummy by writing its id into deqTid before
+ * head moves, so helpers know whose descriptor to complete. Fast path
+ * threads check one other thread's announcement every WFQ_HELP_DELAY
+ * operations, so nobody waits on a fast path that keeps winning.
+ *
+ * Descriptors never change once published, a new one replaces the old with
+ * a CAS. Hazard slots: 0 head/tail, 1 next, 2 descriptor. A queue made with
+ * fastPathAttempts 0 sends every operation of a thread with an id down the
+ * slow path, which is how the tests reach the helping code.
+ *****************************************************************************/
+class wfqueue
+{
+public:
+    class node : public pooled
+    {
+    public:
+        node (int v, int tid) : val(v), next(NULL), enqTid(tid), deqTid(WFQ_NONE){}
+        int val;
+        atomic<node *> next;
+        int enqTid;
+        atomic<int> deqTid;
+    };
+    class desc : public pooled
+    {
+    public:
+        desc (long ph, bool pend, bool enq, node * n, int v)
+            : phase(ph), pending(pend), enqueue(enq), target(n), val(v){}
+        long phase;
+        bool pending;
+        bool enqueue;
+        node * target;  // Node being enqueued, or the dummy a dequeue claimed
+        int val;        // What a finished dequeue got
+    };
+    wfqueue(int fastPathAttempts = WFQ_MAX_FAILURES);
+    ~wfqueue();
+    void enqueue(int val);
+    int dequeue();
+    void report();
+private:
+    atomic<node *> head;
+    char pad0[CACHE_LINE - sizeof(atomic<node *>)];
+    atomic<node *> tail;
+    char pad1[CACHE_LINE - sizeof(atomic<node *>)];
+    atomic<desc *> state[WFQ_MAX_THREADS];
+    atomic<long> phaseCounter;
+    int fastAttempts;
+    threadids ids;
+    atomic<unsigned long> maxEnqRetries;
+    atomic<unsigned long> maxDeqRetries;
+    atomic<unsigned long> slowOps;
+    int MyId();
+    int Threads();
+    desc * Pending(int tid, long ph);
+    void HelpOthers(int tid);
+    void Help(long ph, unsigned long & retries);
+    void HelpEnq(int tid, long ph, unsigned long & retries);
+    void HelpDeq(int tid, long ph, unsigned long & retries);
+    void HelpFinishEnq();
+    void HelpFinishDeq();
+    bool FastEnqueue(node * n, unsigned long & retries, int attempts);
+    bool FastDequeue(int & val, unsigned long & retries, int attempts);
+};
+
+#endif
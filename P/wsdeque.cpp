@@ -0,0 +1,139 @@
+#include "wsdeque.h"
+
+/******************************************************************************
+ * Chase-Lev Work-Stealing Deque
+ * Credit goes to David Chase and Yossi Lev - "Dynamic Circular Work-Stealing
+ * Deque" (SPAA 2005), and to Nhat Minh Le, Antoniu Pop, Albert Cohen and
+ * Francesco Zappa Nardelli - "Correct and Efficient Work-Stealing for Weak
+ * Memory Models" (PPoPP 2013) for the memory orders
+ *****************************************************************************/
+wsdeque::array::array(size_t size)
+{
+    buffer = new atomic<int>[size];
+    mask = size - 1;
+}
+
+wsdeque::array::~array()
+{
+    delete[] buffer;
+}
+
+wsdeque::wsdeque(size_t capacity)
+{
+    size_t size = 2;
+    while (size < capacity)
+    {
+        size <<= 1;
+    }
+    top.store(0, memory_order_relaxed);
+    bottom.store(0, memory_order_relaxed);
+    current.store(new array(size), memory_order_relaxed);
+}
+
+wsdeque::~wsdeque()
+{
+    delete current.load();
+    for (size_t i = 0; i < old.size(); ++i)
+    {
+        delete old[i];
+    }
+}
+
+size_t wsdeque::capacity()
+{
+    return current.load(memory_order_relaxed)->mask + 1;
+}
+
+/******************************************************************************
+ * @brief wsdeque::Grow - Owner only. Copies the live range [t, b) into an
+ *                        array twice the size and publishes it.
+ * @param a - the full array
+ *        t - top when it was found full
+ *        b - bottom
+ * @return array * - the new array
+ *****************************************************************************/
+wsdeque::array * wsdeque::Grow(array * a, long t, long b)
+{
+    array * bigger = new array((a->mask + 1) << 1);
+    for (long i = t; i < b; ++i)
+    {
+        bigger->buffer[i & bigger->mask].store(a->buffer[i & a->mask].load(memory_order_relaxed),
+                                               memory_order_relaxed);
+    }
+    current.store(bigger, memory_order_release);
+    old.push_back(a);
+    return bigger;
+}
+
+/******************************************************************************
+ * @brief wsdeque::push - Owner only
+ * @param val - the value being pushed
+ * @return none
+ *****************************************************************************/
+void wsdeque::push(int val)
+{
+    long b = bottom.load(memory_order_relaxed);
+    long t = top.load(memory_order_acquire);
+    array * a = current.load(memory_order_relaxed);
+    if (b - t > (long)a->mask)
+    {
+        a = Grow(a, t, b);
+    }
+    a->buffer[b & a->mask].store(val, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);  // Element before the new bottom
+    bottom.store(b + 1, memory_order_relaxed);
+}
+
+/******************************************************************************
+ * @brief wsdeque::pop - Owner only. Takes the newest element.
+ * @param none
+ * @return int - the value or -2 == EMPTY
+ *****************************************************************************/
+int wsdeque::pop()
+{
+    long b = bottom.load(memory_order_relaxed) - 1;
+    array * a = current.load(memory_order_relaxed);
+    bottom.store(b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);  // Claim b before reading top
+    long t = top.load(memory_order_relaxed);
+    if (t > b)
+    {
+        bottom.store(b + 1, memory_order_relaxed);
+        return -2;
+    }
+    int val = a->buffer[b & a->mask].load(memory_order_relaxed);
+    if (t == b)
+    {
+        // Last element, a thief may be taking it too
+        if (!top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+        {
+            val = -2;
+        }
+        bottom.store(b + 1, memory_order_relaxed);
+    }
+    return val;
+}
+
+/******************************************************************************
+ * @brief wsdeque::steal - Any thread. Takes the oldest element.
+ * @param none
+ * @return int - the value, -2 == EMPTY or WSD_ABORT if another thread took
+ *               it first
+ *****************************************************************************/
+int wsdeque::steal()
+{
+    long t = top.load(memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);  // Read top before bottom
+    long b = bottom.load(memory_order_acquire);
+    if (t >= b)
+    {
+        return -2;
+    }
+    array * a = current.load(memory_order_acquire);
+    int val = a->buffer[t & a->mask].load(memory_order_relaxed);
+    if (!top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+    {
+        return WSD_ABORT;
+    }
+    return val;
+}
@@ -0,0 +1,51 @@
+#ifndef WSDEQUE_H
+#define WSDEQUE_H
+
+#include <atomic>
+#include <vector>
+#include <stddef.h>
+#include "ringqueue.h"  // CACHE_LINE
+
+using namespace std;
+
+#define WSD_CAPACITY 1024       // Starting slots, rounded up to a power of two
+#define WSD_ABORT    -3         // steal lost a race, the deque may not be empty
+
+/******************************************************************************
+ * Chase-Lev Work-Stealing Deque (C11 version of Le, Pop, Cohen and Zappa
+ * Nardelli)
+ * One owner pushes and pops at the bottom, any thread steals from the top.
+ * The owner's push is a plain store published by a release fence and its
+ * pop only races with thieves for the last element, so the owner never
+ * takes a CAS otherwise. A full circular array is replaced by one twice the
+ * size. Thieves may still be reading the old one, so the owner keeps it
+ * until the deque is destroyed, which costs at most the size of the last
+ * array again.
+ *****************************************************************************/
+class wsdeque
+{
+public:
+    struct array
+    {
+        size_t mask;
+        atomic<int> * buffer;
+        array(size_t size);
+        ~array();
+    };
+    wsdeque(size_t capacity);
+    ~wsdeque();
+    void push(int val);
+    int pop();
+    int steal();
+    size_t capacity();
+private:
+    atomic<long> top;
+    char pad0[CACHE_LINE - sizeof(atomic<long>)];
+    atomic<long> bottom;        // Owner's line
+    atomic<array *> current;
+    vector<array *> old;
+    char pad1[CACHE_LINE - sizeof(atomic<long>) - sizeof(atomic<array *>) - sizeof(vector<array *>)];
+    array * Grow(array * a, long t, long b);
+};
+
+#endif